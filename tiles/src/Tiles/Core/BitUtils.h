@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Tiles
+{
+    namespace BitUtils
+    {
+        // Index of the lowest set bit, value must not be zero
+        inline uint32_t CountTrailingZeros(uint32_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, value);
+            return static_cast<uint32_t>(index);
+#else
+            return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+        }
+
+        // Index of the highest set bit, value must not be zero
+        inline uint32_t FindLastSet(uint32_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse(&index, value);
+            return static_cast<uint32_t>(index);
+#else
+            return 31u - static_cast<uint32_t>(__builtin_clz(value));
+#endif
+        }
+
+        inline uint32_t PopCount(uint32_t value)
+        {
+#ifdef _MSC_VER
+            return static_cast<uint32_t>(__popcnt(value));
+#else
+            return static_cast<uint32_t>(__builtin_popcount(value));
+#endif
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Tiles
+{
+    // Little endian byte encoding for data that never leaves the editor in a readable form.
+    // Counts, indices and coordinates go through LEB128 varints, so small values take one byte.
+    class ByteWriter
+    {
+    public:
+        ByteWriter() = default;
+        ~ByteWriter() = default;
+
+        void WriteU8(uint8_t value) { m_Bytes.push_back(value); }
+
+        void WriteU32(uint32_t value)
+        {
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                m_Bytes.push_back(static_cast<uint8_t>(value >> shift));
+            }
+        }
+
+        void WriteU64(uint64_t value)
+        {
+            for (int shift = 0; shift < 64; shift += 8)
+            {
+                m_Bytes.push_back(static_cast<uint8_t>(value >> shift));
+            }
+        }
+
+        void WriteVarUInt(uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                m_Bytes.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            m_Bytes.push_back(static_cast<uint8_t>(value));
+        }
+
+        // Zigzag encoded, so small negative values stay small
+        void WriteVarInt(int64_t value) { WriteVarUInt((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+
+        void WriteBool(bool value) { WriteU8(value ? 1 : 0); }
+
+        void WriteString(const std::string& value)
+        {
+            WriteVarUInt(value.size());
+            WriteBytes(value.data(), value.size());
+        }
+
+        void WriteBytes(const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            m_Bytes.insert(m_Bytes.end(), bytes, bytes + size);
+        }
+
+        size_t GetSize() const { return m_Bytes.size(); }
+        const std::vector<uint8_t>& GetBytes() const { return m_Bytes; }
+        std::vector<uint8_t> TakeBytes() { return std::move(m_Bytes); }
+
+    private:
+        std::vector<uint8_t> m_Bytes;               // Everything written so far
+    };
+
+    // Reads what ByteWriter wrote. Reading past the end throws std::runtime_error.
+    class ByteReader
+    {
+    public:
+        ByteReader(const uint8_t* data, size_t size) : m_Data(data), m_Size(size) {}
+        explicit ByteReader(const std::vector<uint8_t>& bytes) : ByteReader(bytes.data(), bytes.size()) {}
+
+        uint8_t ReadU8()
+        {
+            Require(1);
+            return m_Data[m_Position++];
+        }
+
+        uint32_t ReadU32()
+        {
+            Require(4);
+            uint32_t value = 0;
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                value |= static_cast<uint32_t>(m_Data[m_Position++]) << shift;
+            }
+            return value;
+        }
+
+        uint64_t ReadU64()
+        {
+            Require(8);
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 8)
+            {
+                value |= static_cast<uint64_t>(m_Data[m_Position++]) << shift;
+            }
+            return value;
+        }
+
+        uint64_t ReadVarUInt()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t byte = ReadU8();
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+            throw std::runtime_error("ByteReader::ReadVarUInt: Varint is too long");
+        }
+
+        int64_t ReadVarInt()
+        {
+            uint64_t value = ReadVarUInt();
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        bool ReadBool() { return ReadU8() != 0; }
+
+        std::string ReadString()
+        {
+            size_t size = static_cast<size_t>(ReadVarUInt());
+            Require(size);
+            std::string value(reinterpret_cast<const char*>(m_Data + m_Position), size);
+            m_Position += size;
+            return value;
+        }
+
+        void ReadBytes(void* data, size_t size)
+        {
+            Require(size);
+            std::memcpy(data, m_Data + m_Position, size);
+            m_Position += size;
+        }
+
+        // Points into the underlying buffer and skips size bytes
+        const uint8_t* Skip(size_t size)
+        {
+            Require(size);
+            const uint8_t* data = m_Data + m_Position;
+            m_Position += size;
+            return data;
+        }
+
+        size_t GetPosition() const { return m_Position; }
+        size_t GetRemaining() const { return m_Size - m_Position; }
+        bool IsAtEnd() const { return m_Position == m_Size; }
+
+    private:
+        void Require(size_t size) const
+        {
+            if (size > m_Size - m_Position)
+                throw std::runtime_error("ByteReader: Unexpected end of data");
+        }
+
+    private:
+        const uint8_t* m_Data;                      // Bytes being read, owned by the caller
+        size_t m_Size;                              // Number of bytes at m_Data
+        size_t m_Position = 0;                      // Next byte to read
+    };
+}
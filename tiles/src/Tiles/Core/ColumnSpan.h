@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Tiles
+{
+    // Non-owning view over one contiguous attribute column, e.g. the tint column of a TilePalette or the
+    // tile index column of a TileChunk.
+    // Plain pointer iteration keeps scans over a column simple enough for the compiler to vectorize.
+    template<typename T>
+    class ColumnSpan
+    {
+    public:
+        ColumnSpan() = default;
+        ColumnSpan(T* data, size_t size) : m_Data(data), m_Size(size) {}
+
+        T* GetData() const { return m_Data; }
+        size_t GetSize() const { return m_Size; }
+        bool IsEmpty() const { return m_Size == 0; }
+
+        T& operator[](size_t index) const { return m_Data[index]; }
+
+        T* begin() const { return m_Data; }
+        T* end() const { return m_Data + m_Size; }
+
+    private:
+        T* m_Data = nullptr;        // First element of the column
+        size_t m_Size = 0;          // Number of elements in the column
+    };
+}
@@ -1,61 +1,298 @@
 #include "CommandHistory.h"
 
+#include <algorithm>
+
 #include "Commands/Command.h"
 
+#include "Lumina/Core/Log.h"
+
 namespace Tiles
 {
-    void CommandHistory::Execute(std::unique_ptr<Command> command, LayerStack& layerStack)
+    const Command* CommandHistory::Execute(std::unique_ptr<Command> command, LayerStack& layerStack)
     {
         if (!command)
-            return;
+            return nullptr;
 
-        if (!m_UndoStack.empty() && m_UndoStack.back()->Validate(*command))
-            return;
+        if (!m_UndoStack.empty() && m_UndoStack.back().State == EntryState::Live && m_UndoStack.back().Command->Validate(*command))
+            return nullptr;
 
         command->Execute(layerStack);
-        m_UndoStack.push_back(std::move(command));
+        return Push(std::move(command));
+    }
 
-        if (m_UndoStack.size() > MAX_UNDO_STACK_SIZE)
-            m_UndoStack.pop_front();
+    const Command* CommandHistory::Push(std::unique_ptr<Command> command)
+    {
+        if (!command)
+            return nullptr;
+
+        ClearStack(m_RedoStack, m_RedoMemoryUsage);
+        PushUndo(MakeEntry(std::move(command)));
 
-        m_RedoStack.clear();
+        // Rebalancing never packs the top entry, so it is still the live command
+        return m_UndoStack.back().Command.get();
     }
 
-    void CommandHistory::Undo(LayerStack& layerStack)
+    const Command* CommandHistory::Undo(LayerStack& layerStack)
     {
         if (m_UndoStack.empty())
-            return;
+            return nullptr;
 
-        std::unique_ptr<Command> command = std::move(m_UndoStack.back());
-        m_UndoStack.pop_back();
+        std::unique_ptr<Command> command = PopCommand(m_UndoStack, m_UndoMemoryUsage, layerStack);
+        if (!command)
+        {
+            // Older entries build on the lost one, so they can't be undone either
+            ClearStack(m_UndoStack, m_UndoMemoryUsage);
+            return nullptr;
+        }
 
         command->Undo(layerStack);
 
-        m_RedoStack.push_back(std::move(command));
-
-        if (m_RedoStack.size() > MAX_UNDO_STACK_SIZE)
-            m_RedoStack.pop_front();
+        PushRedo(MakeEntry(std::move(command)));
+        return m_RedoStack.back().Command.get();
     }
 
-    void CommandHistory::Redo(LayerStack& layerStack)
+    const Command* CommandHistory::Redo(LayerStack& layerStack)
     {
         if (m_RedoStack.empty())
-            return;
+            return nullptr;
 
-        std::unique_ptr<Command> command = std::move(m_RedoStack.back());
-        m_RedoStack.pop_back();
+        std::unique_ptr<Command> command = PopCommand(m_RedoStack, m_RedoMemoryUsage, layerStack);
+        if (!command)
+        {
+            ClearStack(m_RedoStack, m_RedoMemoryUsage);
+            return nullptr;
+        }
 
         command->Execute(layerStack);
 
-        m_UndoStack.push_back(std::move(command));
-
-        if (m_UndoStack.size() > MAX_UNDO_STACK_SIZE)
-            m_UndoStack.pop_front();
+        PushUndo(MakeEntry(std::move(command)));
+        return m_UndoStack.back().Command.get();
     }
 
     void CommandHistory::Clear()
     {
-        m_UndoStack.clear();
-        m_RedoStack.clear();
+        ClearStack(m_UndoStack, m_UndoMemoryUsage);
+        ClearStack(m_RedoStack, m_RedoMemoryUsage);
+    }
+
+    void CommandHistory::SetMemoryBudget(size_t memoryBudget)
+    {
+        m_MemoryBudget = memoryBudget;
+        Rebalance();
+    }
+
+    void CommandHistory::SetLiveEntryCount(size_t liveEntryCount)
+    {
+        m_LiveEntryCount = liveEntryCount;
+        Rebalance();
+    }
+
+    void CommandHistory::SetSpillBudget(uint64_t spillBudget)
+    {
+        m_SpillBudget = spillBudget;
+        Rebalance();
+    }
+
+    CommandHistory::Entry CommandHistory::MakeEntry(std::unique_ptr<Command> command)
+    {
+        // Measured once per tier change, commands don't change size while they sit in a stack
+        Entry entry;
+        entry.MemoryUsage = sizeof(Entry) + command->GetMemoryUsage();
+        entry.Command = std::move(command);
+        return entry;
+    }
+
+    void CommandHistory::PushUndo(Entry entry)
+    {
+        m_UndoMemoryUsage += entry.MemoryUsage;
+        m_UndoStack.push_back(std::move(entry));
+        Rebalance();
+    }
+
+    void CommandHistory::PushRedo(Entry entry)
+    {
+        m_RedoMemoryUsage += entry.MemoryUsage;
+        m_RedoStack.push_back(std::move(entry));
+        Rebalance();
+    }
+
+    std::unique_ptr<Command> CommandHistory::PopCommand(std::deque<Entry>& stack, size_t& memoryUsage, const LayerStack& layerStack)
+    {
+        // Read back before releasing, releasing the last spilled entry truncates the spill file
+        std::unique_ptr<Command> command = Rehydrate(stack.back(), layerStack);
+        Release(stack.back(), memoryUsage);
+        stack.pop_back();
+        return command;
+    }
+
+    void CommandHistory::DropOldest(std::deque<Entry>& stack, size_t& memoryUsage)
+    {
+        Release(stack.front(), memoryUsage);
+        stack.pop_front();
+    }
+
+    void CommandHistory::ClearStack(std::deque<Entry>& stack, size_t& memoryUsage)
+    {
+        while (!stack.empty())
+        {
+            DropOldest(stack, memoryUsage);
+        }
+    }
+
+    void CommandHistory::Release(const Entry& entry, size_t& memoryUsage)
+    {
+        memoryUsage -= entry.MemoryUsage;
+
+        if (entry.State == EntryState::Packed)
+            m_PackedCount--;
+
+        if (entry.State == EntryState::Spilled)
+        {
+            m_SpilledCount--;
+            m_SpilledBytes -= entry.SpillSize;
+
+            // Nothing in the file is needed anymore
+            if (m_SpilledCount == 0)
+                m_SpillFile.Reset();
+        }
+    }
+
+    std::unique_ptr<Command> CommandHistory::Rehydrate(Entry& entry, const LayerStack& layerStack)
+    {
+        if (entry.State == EntryState::Live)
+            return std::move(entry.Command);
+
+        try
+        {
+            if (entry.State == EntryState::Spilled)
+                entry.Packed = m_SpillFile.Read(entry.SpillOffset, entry.SpillSize);
+
+            ByteReader reader(entry.Packed);
+            return Command::Read(reader, layerStack);
+        }
+        catch (const std::exception& e)
+        {
+            LUMINA_LOG_INFO("CommandHistory::Rehydrate: Failed to restore history entry: {}", e.what());
+            return nullptr;
+        }
+    }
+
+    void CommandHistory::Rebalance()
+    {
+        PackOlderEntries(m_UndoStack, m_UndoMemoryUsage);
+        PackOlderEntries(m_RedoStack, m_RedoMemoryUsage);
+
+        // Undo entries are older than redo entries from the user's point of view, so they go first
+        while (GetMemoryUsage() > m_MemoryBudget)
+        {
+            if (SpillOldest(m_UndoStack, m_UndoMemoryUsage) || SpillOldest(m_RedoStack, m_RedoMemoryUsage))
+                continue;
+
+            if (m_UndoStack.size() > 1)
+                DropOldest(m_UndoStack, m_UndoMemoryUsage);
+            else if (m_RedoStack.size() > 1)
+                DropOldest(m_RedoStack, m_RedoMemoryUsage);
+            else
+                break;
+        }
+
+        if (m_SpillFile.GetSize() <= m_SpillBudget)
+            return;
+
+        // Spilled entries are the oldest of their stack, so they are always at the front
+        while (m_SpilledBytes > m_SpillBudget)
+        {
+            if (!m_UndoStack.empty() && m_UndoStack.front().State == EntryState::Spilled)
+                DropOldest(m_UndoStack, m_UndoMemoryUsage);
+            else if (!m_RedoStack.empty() && m_RedoStack.front().State == EntryState::Spilled)
+                DropOldest(m_RedoStack, m_RedoMemoryUsage);
+            else
+                break;
+        }
+
+        CompactSpillFile();
+    }
+
+    void CommandHistory::PackOlderEntries(std::deque<Entry>& stack, size_t& memoryUsage)
+    {
+        // The top entry stays live so the next command can be merged into it, see Command::Validate
+        size_t liveEntryCount = std::max<size_t>(m_LiveEntryCount, 1);
+        if (stack.size() <= liveEntryCount)
+            return;
+
+        // Live entries are always the newest ones, so packing stops at the first entry that isn't live
+        for (size_t i = stack.size() - liveEntryCount; i-- > 0;)
+        {
+            Entry& entry = stack[i];
+            if (entry.State != EntryState::Live)
+                break;
+
+            ByteWriter writer;
+            Command::Write(*entry.Command, writer);
+
+            memoryUsage -= entry.MemoryUsage;
+            entry.Command.reset();
+            entry.Packed = writer.TakeBytes();
+            entry.Packed.shrink_to_fit();
+            entry.State = EntryState::Packed;
+            entry.MemoryUsage = sizeof(Entry) + entry.Packed.capacity();
+            memoryUsage += entry.MemoryUsage;
+
+            m_PackedCount++;
+        }
+    }
+
+    bool CommandHistory::SpillOldest(std::deque<Entry>& stack, size_t& memoryUsage)
+    {
+        // Spilled entries are always the oldest ones, the first packed entry after them is next
+        for (Entry& entry : stack)
+        {
+            if (entry.State == EntryState::Spilled)
+                continue;
+
+            if (entry.State != EntryState::Packed || !m_SpillFile.Write(entry.Packed, entry.SpillOffset))
+                return false;
+
+            memoryUsage -= entry.MemoryUsage;
+            entry.SpillSize = entry.Packed.size();
+            entry.Packed = {};
+            entry.State = EntryState::Spilled;
+            entry.MemoryUsage = sizeof(Entry);
+            memoryUsage += entry.MemoryUsage;
+
+            m_PackedCount--;
+            m_SpilledCount++;
+            m_SpilledBytes += entry.SpillSize;
+            return true;
+        }
+
+        return false;
+    }
+
+    void CommandHistory::CompactSpillFile()
+    {
+        std::vector<std::pair<uint64_t*, size_t>> blocks;
+        for (std::deque<Entry>* stack : { &m_UndoStack, &m_RedoStack })
+        {
+            for (Entry& entry : *stack)
+            {
+                if (entry.State == EntryState::Spilled)
+                    blocks.push_back({ &entry.SpillOffset, entry.SpillSize });
+            }
+        }
+
+        try
+        {
+            m_SpillFile.Compact(blocks);
+        }
+        catch (const std::exception& e)
+        {
+            // Offsets may be half updated, none of the spilled entries can be trusted anymore
+            LUMINA_LOG_INFO("CommandHistory::CompactSpillFile: {}, dropping spilled history", e.what());
+            while (!m_UndoStack.empty() && m_UndoStack.front().State == EntryState::Spilled)
+                DropOldest(m_UndoStack, m_UndoMemoryUsage);
+            while (!m_RedoStack.empty() && m_RedoStack.front().State == EntryState::Spilled)
+                DropOldest(m_RedoStack, m_RedoMemoryUsage);
+        }
     }
-}
\ No newline at end of file
+}
@@ -2,8 +2,10 @@
 
 #include <deque>
 #include <memory>
+#include <vector>
 
 #include "LayerStack.h"
+#include "SpillFile.h"
 
 #include "Commands/Command.h"
 
@@ -12,25 +14,110 @@ namespace Tiles
     class Command;
     class LayerStack;
 
-    static const size_t MAX_UNDO_STACK_SIZE = 1000;
+    static const size_t DEFAULT_HISTORY_MEMORY_BUDGET = 256 * 1024 * 1024;
+    static const size_t DEFAULT_HISTORY_LIVE_ENTRIES = 64;
+    static const uint64_t DEFAULT_HISTORY_SPILL_BUDGET = 4ull * 1024 * 1024 * 1024;
 
+    // Undo and redo stacks kept in three tiers. The entries nearest the current state stay live
+    // commands. Older entries are packed into their byte form (see Command::Serialize). Once the
+    // stacks together hold more memory than the budget, the oldest packed entries are spilled to a
+    // temp file. Packed and spilled entries are only rebuilt when undo or redo reaches them.
+    //
+    // When there is nothing left to spill, the oldest entries are dropped, as they are when the
+    // spill file outgrows its own budget. The entry on top of each stack is always kept, so the
+    // last edit can be undone (and redone) even when it alone is over budget.
     class CommandHistory
     {
     public:
-        CommandHistory() = default;
+        CommandHistory(size_t memoryBudget = DEFAULT_HISTORY_MEMORY_BUDGET, size_t liveEntryCount = DEFAULT_HISTORY_LIVE_ENTRIES, uint64_t spillBudget = DEFAULT_HISTORY_SPILL_BUDGET)
+            : m_MemoryBudget(memoryBudget), m_LiveEntryCount(liveEntryCount), m_SpillBudget(spillBudget) {}
 
-        void Execute(std::unique_ptr<Command> command, LayerStack& layerStack);
+        // Each returns the command it applied, null when nothing changed. The command stays owned by
+        // the history and is only valid until the next call.
+        const Command* Execute(std::unique_ptr<Command> command, LayerStack& layerStack);
+
+        // Records a command whose edits are already on the layer stack, without executing it again
+        const Command* Push(std::unique_ptr<Command> command);
         
-        void Undo(LayerStack& layerStack);
-        void Redo(LayerStack& layerStack);
+        const Command* Undo(LayerStack& layerStack);
+        const Command* Redo(LayerStack& layerStack);
         
         bool CanUndo() const { return !m_UndoStack.empty(); }
         bool CanRedo() const { return !m_RedoStack.empty(); }
         
         void Clear();
 
+        void SetMemoryBudget(size_t memoryBudget);
+        size_t GetMemoryBudget() const { return m_MemoryBudget; }
+        void SetLiveEntryCount(size_t liveEntryCount);
+        size_t GetLiveEntryCount() const { return m_LiveEntryCount; }
+        void SetSpillBudget(uint64_t spillBudget);
+        uint64_t GetSpillBudget() const { return m_SpillBudget; }
+
+        size_t GetUndoCount() const { return m_UndoStack.size(); }
+        size_t GetRedoCount() const { return m_RedoStack.size(); }
+        size_t GetPackedCount() const { return m_PackedCount; }
+        size_t GetSpilledCount() const { return m_SpilledCount; }
+
+        // Bytes held in memory by each stack, live commands and packed entries alike
+        size_t GetUndoMemoryUsage() const { return m_UndoMemoryUsage; }
+        size_t GetRedoMemoryUsage() const { return m_RedoMemoryUsage; }
+        size_t GetMemoryUsage() const { return m_UndoMemoryUsage + m_RedoMemoryUsage; }
+
+        // Bytes of spilled entries, and the part of the spill file in use including dropped entries
+        uint64_t GetSpilledBytes() const { return m_SpilledBytes; }
+        uint64_t GetSpillFileSize() const { return m_SpillFile.GetSize(); }
+
+    private:
+        enum class EntryState : uint8_t
+        {
+            Live,
+            Packed,
+            Spilled
+        };
+
+        struct Entry
+        {
+            EntryState State = EntryState::Live;
+            std::unique_ptr<Tiles::Command> Command;        // Set while live
+            std::vector<uint8_t> Packed;                    // Byte form while packed
+            uint64_t SpillOffset = 0;                       // Position in the spill file while spilled
+            size_t SpillSize = 0;                           // Length in the spill file while spilled
+            size_t MemoryUsage = 0;                         // Bytes counted against the memory budget
+        };
+
+        static Entry MakeEntry(std::unique_ptr<Command> command);
+
+        void PushUndo(Entry entry);
+        void PushRedo(Entry entry);
+        // Removes the top entry, null when its bytes could not be read back
+        std::unique_ptr<Command> PopCommand(std::deque<Entry>& stack, size_t& memoryUsage, const LayerStack& layerStack);
+        void DropOldest(std::deque<Entry>& stack, size_t& memoryUsage);
+        void ClearStack(std::deque<Entry>& stack, size_t& memoryUsage);
+        void Release(const Entry& entry, size_t& memoryUsage);
+
+        // Returns the live command of an entry, null when its bytes could not be read back
+        std::unique_ptr<Command> Rehydrate(Entry& entry, const LayerStack& layerStack);
+
+        // Packs, spills and drops entries until every budget holds again
+        void Rebalance();
+        void PackOlderEntries(std::deque<Entry>& stack, size_t& memoryUsage);
+        bool SpillOldest(std::deque<Entry>& stack, size_t& memoryUsage);
+        void CompactSpillFile();
+
     private:
-        std::deque<std::unique_ptr<Command>> m_UndoStack;
-        std::deque<std::unique_ptr<Command>> m_RedoStack;
+        std::deque<Entry> m_UndoStack;
+        std::deque<Entry> m_RedoStack;
+        size_t m_UndoMemoryUsage = 0;                       // Bytes held by the entries in m_UndoStack
+        size_t m_RedoMemoryUsage = 0;                       // Bytes held by the entries in m_RedoStack
+        size_t m_PackedCount = 0;                           // Entries in the packed tier
+        size_t m_SpilledCount = 0;                          // Entries in the spilled tier
+        uint64_t m_SpilledBytes = 0;                        // Spill file bytes still referenced by entries
+
+        size_t m_MemoryBudget;                              // Bytes both stacks may hold in memory together
+        size_t m_LiveEntryCount;                            // Entries per stack kept as live commands
+        uint64_t m_SpillBudget;                             // Bytes the spill file may grow to
+
+        SpillFile m_SpillFile;                              // Backing store of spilled entries
     };
-}
\ No newline at end of file
+}
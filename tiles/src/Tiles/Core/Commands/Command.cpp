@@ -0,0 +1,47 @@
+#include "Command.h"
+
+#include <stdexcept>
+
+#include "LayerAddCommand.h"
+#include "LayerClearCommand.h"
+#include "LayerDeleteCommand.h"
+#include "LayerFillCommand.h"
+#include "LayerInsertCommand.h"
+#include "LayerMoveDownCommand.h"
+#include "LayerMoveUpCommand.h"
+#include "LayerSwapCommand.h"
+#include "StrokeCommand.h"
+#include "TileEraseCommand.h"
+#include "TilePaintCommand.h"
+#include "TransactionCommand.h"
+
+namespace Tiles
+{
+	void Command::Write(const Command& command, ByteWriter& writer)
+	{
+		writer.WriteU8(static_cast<uint8_t>(command.GetType()));
+		command.Serialize(writer);
+	}
+
+	std::unique_ptr<Command> Command::Read(ByteReader& reader, const LayerStack& layerStack)
+	{
+		CommandType type = static_cast<CommandType>(reader.ReadU8());
+		switch (type)
+		{
+		case CommandType::TilePaint: return TilePaintCommand::Deserialize(reader, layerStack);
+		case CommandType::TileErase: return TileEraseCommand::Deserialize(reader, layerStack);
+		case CommandType::LayerFill: return LayerFillCommand::Deserialize(reader, layerStack);
+		case CommandType::LayerClear: return LayerClearCommand::Deserialize(reader, layerStack);
+		case CommandType::LayerAdd: return LayerAddCommand::Deserialize(reader, layerStack);
+		case CommandType::LayerInsert: return LayerInsertCommand::Deserialize(reader, layerStack);
+		case CommandType::LayerDelete: return LayerDeleteCommand::Deserialize(reader, layerStack);
+		case CommandType::LayerSwap: return LayerSwapCommand::Deserialize(reader, layerStack);
+		case CommandType::LayerMoveUp: return LayerMoveUpCommand::Deserialize(reader, layerStack);
+		case CommandType::LayerMoveDown: return LayerMoveDownCommand::Deserialize(reader, layerStack);
+		case CommandType::Stroke: return StrokeCommand::Deserialize(reader, layerStack);
+		case CommandType::Transaction: return TransactionCommand::Deserialize(reader, layerStack);
+		}
+
+		throw std::runtime_error("Command::Read: Unknown command type " + std::to_string(static_cast<int>(type)));
+	}
+}
@@ -1,9 +1,29 @@
 #pragma once
 
+#include <memory>
+
+#include "../ByteStream.h"
 #include "../LayerStack.h"
 
 namespace Tiles
 {
+	// Tag written in front of a serialized command, values are only ever added
+	enum class CommandType : uint8_t
+	{
+		TilePaint = 0,
+		TileErase,
+		LayerFill,
+		LayerClear,
+		LayerAdd,
+		LayerInsert,
+		LayerDelete,
+		LayerSwap,
+		LayerMoveUp,
+		LayerMoveDown,
+		Stroke,
+		Transaction
+	};
+
 	class Command
 	{
 	public:
@@ -13,5 +33,17 @@ namespace Tiles
 		virtual void Undo(LayerStack& layerStack) = 0;
 
 		virtual bool Validate(const Command& other) const { return false; }
+
+		// Bytes kept alive by the command while it sits in the history, including the command itself
+		virtual size_t GetMemoryUsage() const = 0;
+
+		// Compact byte form that lets CommandHistory move old entries out of memory. Serialize writes
+		// the command's fields, Write and Read add the type tag. Tile indices refer to the palette of
+		// the layer stack, which Read uses to rebuild layer snapshots.
+		virtual CommandType GetType() const = 0;
+		virtual void Serialize(ByteWriter& writer) const = 0;
+
+		static void Write(const Command& command, ByteWriter& writer);
+		static std::unique_ptr<Command> Read(ByteReader& reader, const LayerStack& layerStack);
 	};
 }
\ No newline at end of file
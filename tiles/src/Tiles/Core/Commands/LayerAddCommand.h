@@ -39,6 +39,30 @@ namespace Tiles
             return false;
         }
 
+        virtual size_t GetMemoryUsage() const override
+        {
+            return sizeof(*this) + m_LayerName.capacity();
+        }
+
+        virtual CommandType GetType() const override { return CommandType::LayerAdd; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_Index);
+            writer.WriteString(m_LayerName);
+            writer.WriteBool(m_HasExecuted);
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            size_t index = static_cast<size_t>(reader.ReadVarUInt());
+
+            auto command = std::make_unique<LayerAddCommand>(reader.ReadString());
+            command->m_Index = index;
+            command->m_HasExecuted = reader.ReadBool();
+            return command;
+        }
+
     private:
         size_t m_Index;
         std::string m_LayerName;
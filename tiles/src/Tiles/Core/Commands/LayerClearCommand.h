@@ -1,6 +1,7 @@
 #pragma once
 #include "Command.h"
 #include "../LayerStack.h"
+#include "../TileDelta.h"
 #include "../TileLayer.h"
 
 namespace Tiles
@@ -17,7 +18,7 @@ namespace Tiles
         {
             if (!m_HasExecuted)
             {
-                m_PreviousLayer = layerStack.GetLayer(m_Index);
+                m_Delta = TileDelta::FromPaintedTiles(layerStack.GetLayer(m_Index));
                 m_HasExecuted = true;
             }
 
@@ -26,7 +27,7 @@ namespace Tiles
 
         virtual void Undo(LayerStack& layerStack) override
         {
-            layerStack.ReplaceLayer(m_Index, m_PreviousLayer);
+            m_Delta.Restore(layerStack.GetLayer(m_Index));
         }
 
         virtual bool Validate(const Command& other) const override
@@ -34,9 +35,31 @@ namespace Tiles
             return false;
         }
 
+        virtual size_t GetMemoryUsage() const override
+        {
+            return sizeof(*this) + m_Delta.GetMemoryUsage();
+        }
+
+        virtual CommandType GetType() const override { return CommandType::LayerClear; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_Index);
+            writer.WriteBool(m_HasExecuted);
+            m_Delta.Serialize(writer);
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            auto command = std::make_unique<LayerClearCommand>(static_cast<size_t>(reader.ReadVarUInt()));
+            command->m_HasExecuted = reader.ReadBool();
+            command->m_Delta = TileDelta::Deserialize(reader);
+            return command;
+        }
+
     private:
         size_t m_Index;
-        TileLayer m_PreviousLayer;
+        TileDelta m_Delta;
         bool m_HasExecuted;
     };
 }
\ No newline at end of file
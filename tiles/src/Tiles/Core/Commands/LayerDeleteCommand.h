@@ -1,6 +1,7 @@
 #pragma once
 #include "Command.h"
 #include "../LayerStack.h"
+#include "../TileDelta.h"
 #include "../TileLayer.h"
 
 namespace Tiles
@@ -35,6 +36,50 @@ namespace Tiles
             return false;
         }
 
+        virtual size_t GetMemoryUsage() const override
+        {
+            return sizeof(*this) + m_PreviousLayer.GetMemoryUsage();
+        }
+
+        virtual CommandType GetType() const override { return CommandType::LayerDelete; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_Index);
+            writer.WriteBool(m_HasExecuted);
+
+            // The snapshot is written as its settings plus its painted tiles
+            writer.WriteString(m_PreviousLayer.GetName());
+            writer.WriteBool(m_PreviousLayer.GetVisibility());
+            writer.WriteVarInt(static_cast<int32_t>(m_PreviousLayer.GetRenderGroup()));
+            writer.WriteBool(m_PreviousLayer.IsUnbounded());
+            writer.WriteVarUInt(m_PreviousLayer.GetWidth());
+            writer.WriteVarUInt(m_PreviousLayer.GetHeight());
+            TileDelta::FromPaintedTiles(m_PreviousLayer).Serialize(writer);
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            auto command = std::make_unique<LayerDeleteCommand>(static_cast<size_t>(reader.ReadVarUInt()));
+            command->m_HasExecuted = reader.ReadBool();
+
+            std::string name = reader.ReadString();
+            bool visible = reader.ReadBool();
+            RenderGroup renderGroup = static_cast<RenderGroup>(reader.ReadVarInt());
+            bool unbounded = reader.ReadBool();
+            uint32_t width = static_cast<uint32_t>(reader.ReadVarUInt());
+            uint32_t height = static_cast<uint32_t>(reader.ReadVarUInt());
+
+            TileLayer& layer = command->m_PreviousLayer;
+            layer = TileLayer(width, height, layerStack.GetPalette());
+            layer.SetUnbounded(unbounded);
+            layer.SetName(name);
+            layer.SetVisibility(visible);
+            layer.SetRenderGroup(renderGroup);
+            TileDelta::Deserialize(reader).Restore(layer);
+            return command;
+        }
+
     private:
         size_t m_Index;
         TileLayer m_PreviousLayer;
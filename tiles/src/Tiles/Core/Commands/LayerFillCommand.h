@@ -1,10 +1,10 @@
 #pragma once
 
-#include <queue>
-
 #include "Command.h"
 
+#include "../FloodFill.h"
 #include "../Tile.h"
+#include "../TileDelta.h"
 #include "../TileLayer.h"
 
 namespace Tiles
@@ -12,8 +12,9 @@ namespace Tiles
     class LayerFillCommand : public Command
     {
     public:
-        LayerFillCommand(size_t x, size_t y, size_t index, const Tile& fillTile)
-            : m_X(x), m_Y(y), m_Index(index), m_FillTile(fillTile), m_HasExecuted(false)
+        // fillTileIndex refers to the layer stack palette
+        LayerFillCommand(int32_t x, int32_t y, size_t index, uint16_t fillTileIndex)
+            : m_X(x), m_Y(y), m_Index(index), m_FillTileIndex(fillTileIndex), m_HasExecuted(false)
         {
         }
 
@@ -21,25 +22,41 @@ namespace Tiles
         {
             TileLayer& layer = layerStack.GetLayer(m_Index);
 
-            if (!m_HasExecuted)
+            // Redo writes the recorded tiles again instead of searching for the region
+            if (m_HasExecuted)
             {
-                m_PreviousLayer = layer;
-                m_HasExecuted = true;
+                m_Delta.Apply(layer, m_FillTileIndex);
+                return;
             }
+            m_HasExecuted = true;
 
-            const Tile& targetTile = layer.GetTile(m_X, m_Y);
-            if (targetTile == m_FillTile)
+            uint16_t targetTileIndex = layer.GetTileIndex(m_X, m_Y);
+            if (targetTileIndex == m_FillTileIndex)
                 return;
 
-            TileLayer newLayer = m_PreviousLayer;
-            FloodFill(newLayer, m_X, m_Y, targetTile);
+            // Spans grow from the seed first, which costs what the region costs. Only a region that
+            // turns out large is started over and labelled on every core, whose cost follows the bounds.
+            TileBounds fillBounds = GetFillBounds(layer);
+            bool canRunParallel = WorkerPool::Get().GetThreadCount() > 0 && static_cast<size_t>(fillBounds.GetWidth()) * fillBounds.GetHeight() >= FloodFill::PARALLEL_TILE_COUNT;
+            size_t maxCount = canRunParallel ? FloodFill::PARALLEL_TILE_COUNT : SIZE_MAX;
 
-            layerStack.ReplaceLayer(m_Index, newLayer);
+            FloodFill fill(layer, fillBounds, targetTileIndex);
+            if (fill.Run(m_X, m_Y, maxCount) < maxCount)
+            {
+                m_Delta = fill.GetDelta();
+                fill.Apply(layer, m_FillTileIndex);
+                return;
+            }
+
+            FloodFill parallelFill(layer, fillBounds, targetTileIndex);
+            parallelFill.RunParallel(m_X, m_Y);
+            m_Delta = parallelFill.GetDelta();
+            parallelFill.Apply(layer, m_FillTileIndex);
         }
 
         virtual void Undo(LayerStack& layerStack) override
         {
-            layerStack.ReplaceLayer(m_Index, m_PreviousLayer);
+            m_Delta.Restore(layerStack.GetLayer(m_Index));
         }
 
         virtual bool Validate(const Command& other) const override
@@ -47,44 +64,52 @@ namespace Tiles
             return false;
         }
 
-    private:
-        void FloodFill(TileLayer& layer, size_t startX, size_t startY, const Tile& targetTile)
+        virtual size_t GetMemoryUsage() const override
         {
-            std::queue<std::pair<size_t, size_t>> tileQueue;
-            tileQueue.push({ startX, startY });
-
-            const std::vector<std::pair<int, int>> directions = { {1, 0}, {0, 1}, {-1, 0}, {0, -1} };
-
-            while (!tileQueue.empty())
-            {
-                auto [x, y] = tileQueue.front();
-                tileQueue.pop();
+            return sizeof(*this) + m_Delta.GetMemoryUsage();
+        }
 
-                if (!layer.IsValidPosition(x, y))
-                    continue;
+        virtual CommandType GetType() const override { return CommandType::LayerFill; }
 
-                Tile& tile = layer.GetTile(x, y);
-                if (tile != targetTile)
-                    continue;
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarInt(m_X);
+            writer.WriteVarInt(m_Y);
+            writer.WriteVarUInt(m_Index);
+            writer.WriteVarUInt(m_FillTileIndex);
+            writer.WriteBool(m_HasExecuted);
+            m_Delta.Serialize(writer);
+        }
 
-                tile = m_FillTile;
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            int32_t x = static_cast<int32_t>(reader.ReadVarInt());
+            int32_t y = static_cast<int32_t>(reader.ReadVarInt());
+            size_t index = static_cast<size_t>(reader.ReadVarUInt());
+            uint16_t fillTileIndex = static_cast<uint16_t>(reader.ReadVarUInt());
+
+            auto command = std::make_unique<LayerFillCommand>(x, y, index, fillTileIndex);
+            command->m_HasExecuted = reader.ReadBool();
+            command->m_Delta = TileDelta::Deserialize(reader);
+            return command;
+        }
 
-                for (const auto& [dx, dy] : directions)
-                {
-                    int newX = static_cast<int>(x) + dx;
-                    int newY = static_cast<int>(y) + dy;
+    private:
+        // Unbounded layers have no edge to stop an empty-area fill, so the fill is limited to the
+        // painted content (plus the clicked tile) grown by one tile on every side
+        TileBounds GetFillBounds(const TileLayer& layer) const
+        {
+            if (!layer.IsUnbounded())
+                return layer.GetBounds();
 
-                    if (newX >= 0 && newY >= 0)
-                    {
-                        tileQueue.push({ static_cast<size_t>(newX), static_cast<size_t>(newY) });
-                    }
-                }
-            }
+            TileBounds bounds = layer.GetPaintedBounds().Union({ m_X, m_Y, m_X + 1, m_Y + 1 });
+            return { bounds.MinX - 1, bounds.MinY - 1, bounds.MaxX + 1, bounds.MaxY + 1 };
         }
 
-        size_t m_X, m_Y, m_Index;
-        Tile m_FillTile;
-        TileLayer m_PreviousLayer;
+        int32_t m_X, m_Y;
+        size_t m_Index;
+        uint16_t m_FillTileIndex;
+        TileDelta m_Delta;
         bool m_HasExecuted;
     };
 }
\ No newline at end of file
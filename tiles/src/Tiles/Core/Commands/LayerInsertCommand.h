@@ -38,6 +38,29 @@ namespace Tiles
             return false;
         }
 
+        virtual size_t GetMemoryUsage() const override
+        {
+            return sizeof(*this) + m_LayerName.capacity();
+        }
+
+        virtual CommandType GetType() const override { return CommandType::LayerInsert; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_InsertIndex);
+            writer.WriteString(m_LayerName);
+            writer.WriteBool(m_HasExecuted);
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            size_t insertIndex = static_cast<size_t>(reader.ReadVarUInt());
+
+            auto command = std::make_unique<LayerInsertCommand>(insertIndex, reader.ReadString());
+            command->m_HasExecuted = reader.ReadBool();
+            return command;
+        }
+
     private:
         size_t m_InsertIndex;
         std::string m_LayerName;
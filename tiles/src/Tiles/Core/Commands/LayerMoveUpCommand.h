@@ -32,6 +32,23 @@ namespace Tiles
             return false;
         }
 
+        virtual size_t GetMemoryUsage() const override
+        {
+            return sizeof(*this);
+        }
+
+        virtual CommandType GetType() const override { return CommandType::LayerMoveUp; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_Index);
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            return std::make_unique<LayerMoveUpCommand>(static_cast<size_t>(reader.ReadVarUInt()));
+        }
+
     private:
         size_t m_Index;
     };
@@ -29,6 +29,26 @@ namespace Tiles
             return false;
         }
 
+        virtual size_t GetMemoryUsage() const override
+        {
+            return sizeof(*this);
+        }
+
+        virtual CommandType GetType() const override { return CommandType::LayerSwap; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_IndexA);
+            writer.WriteVarUInt(m_IndexB);
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            size_t indexA = static_cast<size_t>(reader.ReadVarUInt());
+            size_t indexB = static_cast<size_t>(reader.ReadVarUInt());
+            return std::make_unique<LayerSwapCommand>(indexA, indexB);
+        }
+
     private:
         size_t m_IndexA;
         size_t m_IndexB;
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "Command.h"
+#include "../LayerStack.h"
+#include "../TileLayer.h"
+
+namespace Tiles
+{
+    // Every cell painted or erased during one mouse drag, undone and redone as a single entry.
+    // Cells are written to the layer as the drag goes, each cell is recorded once with the tile
+    // it held before the stroke first touched it.
+    class StrokeCommand : public Command
+    {
+    public:
+        StrokeCommand(size_t index)
+            : m_Index(index)
+        {
+        }
+
+        // Writes tileIndex at (x, y) and records the cell, tileIndex refers to the layer stack palette
+        void Paint(LayerStack& layerStack, int32_t x, int32_t y, uint16_t tileIndex)
+        {
+            if (!layerStack.IsValidLayerIndex(m_Index))
+                return;
+
+            TileLayer& layer = layerStack.GetLayer(m_Index);
+            if (!layer.IsValidPosition(x, y))
+                return;
+
+            auto [cell, inserted] = m_CellLookup.try_emplace(TileLayer::GetChunkKey(x, y), m_Cells.size());
+            if (inserted)
+                m_Cells.push_back({ x, y, layer.GetTileIndex(x, y), tileIndex });
+            else
+                m_Cells[cell->second].NewTileIndex = tileIndex;
+
+            layer.SetTileIndex(x, y, tileIndex);
+        }
+
+        // Called once the drag ends, the lookup is only needed while cells are still coming in
+        void Finish()
+        {
+            m_CellLookup = {};
+            m_Cells.shrink_to_fit();
+        }
+
+        virtual void Execute(LayerStack& layerStack) override
+        {
+            TileLayer& layer = layerStack.GetLayer(m_Index);
+            for (const StrokeCell& cell : m_Cells)
+            {
+                layer.SetTileIndex(cell.X, cell.Y, cell.NewTileIndex);
+            }
+        }
+
+        virtual void Undo(LayerStack& layerStack) override
+        {
+            TileLayer& layer = layerStack.GetLayer(m_Index);
+            for (const StrokeCell& cell : m_Cells)
+            {
+                layer.SetTileIndex(cell.X, cell.Y, cell.PreviousTileIndex);
+            }
+        }
+
+        virtual bool Validate(const Command& other) const override
+        {
+            return false;
+        }
+
+        virtual size_t GetMemoryUsage() const override
+        {
+            // Lookup nodes hold the key, the index and the bucket link
+            return sizeof(*this) + m_Cells.capacity() * sizeof(StrokeCell) +
+                m_CellLookup.size() * (sizeof(uint64_t) + sizeof(size_t) + sizeof(void*)) + m_CellLookup.bucket_count() * sizeof(void*);
+        }
+
+        virtual CommandType GetType() const override { return CommandType::Stroke; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_Index);
+            writer.WriteVarUInt(m_Cells.size());
+
+            // Cells of a drag are mostly next to each other, so positions are stored as steps
+            int32_t previousX = 0;
+            int32_t previousY = 0;
+            for (const StrokeCell& cell : m_Cells)
+            {
+                writer.WriteVarInt(static_cast<int64_t>(cell.X) - previousX);
+                writer.WriteVarInt(static_cast<int64_t>(cell.Y) - previousY);
+                writer.WriteVarUInt(cell.PreviousTileIndex);
+                writer.WriteVarUInt(cell.NewTileIndex);
+                previousX = cell.X;
+                previousY = cell.Y;
+            }
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            auto command = std::make_unique<StrokeCommand>(static_cast<size_t>(reader.ReadVarUInt()));
+
+            size_t cellCount = static_cast<size_t>(reader.ReadVarUInt());
+            command->m_Cells.reserve(std::min<size_t>(cellCount, reader.GetRemaining()));
+
+            int32_t x = 0;
+            int32_t y = 0;
+            for (size_t i = 0; i < cellCount; i++)
+            {
+                x = static_cast<int32_t>(x + reader.ReadVarInt());
+                y = static_cast<int32_t>(y + reader.ReadVarInt());
+                uint16_t previousTileIndex = static_cast<uint16_t>(reader.ReadVarUInt());
+                uint16_t newTileIndex = static_cast<uint16_t>(reader.ReadVarUInt());
+                command->m_Cells.push_back({ x, y, previousTileIndex, newTileIndex });
+            }
+            return command;
+        }
+
+        size_t GetIndex() const { return m_Index; }
+        bool IsEmpty() const { return m_Cells.empty(); }
+
+    private:
+        struct StrokeCell
+        {
+            int32_t X, Y;
+            uint16_t PreviousTileIndex;                             // Tile before the stroke reached the cell
+            uint16_t NewTileIndex;                                  // Last tile the stroke wrote
+        };
+
+        size_t m_Index;
+        std::vector<StrokeCell> m_Cells;                            // Touched cells in the order they were first painted
+        std::unordered_map<uint64_t, size_t> m_CellLookup;          // Cell position, packed like chunk keys, to m_Cells index
+    };
+}
@@ -8,32 +8,31 @@ namespace Tiles
     class TileEraseCommand : public Command
     {
     public:
-        TileEraseCommand(size_t x, size_t y, size_t index)
+        TileEraseCommand(int32_t x, int32_t y, size_t index)
             : m_X(x), m_Y(y), m_Index(index), m_HasExecuted(false)
         {
         }
 
         virtual void Execute(LayerStack& layerStack) override
         {
-            Tile& currentTile = layerStack.GetTile(m_X, m_Y, m_Index);
+            TileLayer& layer = layerStack.GetLayer(m_Index);
+            uint16_t currentTileIndex = layer.GetTileIndex(m_X, m_Y);
 
             if (!m_HasExecuted)
             {
-                m_PreviousTile = currentTile;  // Capture on first execution
+                m_PreviousTileIndex = currentTileIndex;  // Capture on first execution
                 m_HasExecuted = true;
             }
 
-            Tile emptyTile;
-            if (currentTile == emptyTile)
+            if (currentTileIndex == TilePalette::DEFAULT_INDEX)
                 return;
 
-            currentTile.Reset();
+            layer.ResetTile(m_X, m_Y);
         }
 
         virtual void Undo(LayerStack& layerStack) override
         {
-            Tile& currentTile = layerStack.GetTile(m_X, m_Y, m_Index);
-            currentTile = m_PreviousTile;
+            layerStack.GetLayer(m_Index).SetTileIndex(m_X, m_Y, m_PreviousTileIndex);
         }
 
         virtual bool Validate(const Command& other) const override
@@ -44,9 +43,38 @@ namespace Tiles
             return m_X == otherCmd->m_X && m_Y == otherCmd->m_Y && m_Index == otherCmd->m_Index;
         }
 
+        virtual size_t GetMemoryUsage() const override
+        {
+            return sizeof(*this);
+        }
+
+        virtual CommandType GetType() const override { return CommandType::TileErase; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarInt(m_X);
+            writer.WriteVarInt(m_Y);
+            writer.WriteVarUInt(m_Index);
+            writer.WriteVarUInt(m_PreviousTileIndex);
+            writer.WriteBool(m_HasExecuted);
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            int32_t x = static_cast<int32_t>(reader.ReadVarInt());
+            int32_t y = static_cast<int32_t>(reader.ReadVarInt());
+            size_t index = static_cast<size_t>(reader.ReadVarUInt());
+
+            auto command = std::make_unique<TileEraseCommand>(x, y, index);
+            command->m_PreviousTileIndex = static_cast<uint16_t>(reader.ReadVarUInt());
+            command->m_HasExecuted = reader.ReadBool();
+            return command;
+        }
+
     private:
-        size_t m_X, m_Y, m_Index;
-        Tile m_PreviousTile;
+        int32_t m_X, m_Y;
+        size_t m_Index;
+        uint16_t m_PreviousTileIndex = TilePalette::DEFAULT_INDEX;
         bool m_HasExecuted;
     };
-}
\ No newline at end of file
+}
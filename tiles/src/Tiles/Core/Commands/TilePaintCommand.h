@@ -8,31 +8,32 @@ namespace Tiles
     class TilePaintCommand : public Command
     {
     public:
-        TilePaintCommand(size_t x, size_t y, size_t index, const Tile& newTile)
-            : m_X(x), m_Y(y), m_Index(index), m_NewTile(newTile), m_HasExecuted(false)
+        // tileIndex refers to the layer stack palette
+        TilePaintCommand(int32_t x, int32_t y, size_t index, uint16_t tileIndex)
+            : m_X(x), m_Y(y), m_Index(index), m_NewTileIndex(tileIndex), m_HasExecuted(false)
         {
         }
 
         virtual void Execute(LayerStack& layerStack) override
         {
-            Tile& currentTile = layerStack.GetTile(m_X, m_Y, m_Index);
+            TileLayer& layer = layerStack.GetLayer(m_Index);
+            uint16_t currentTileIndex = layer.GetTileIndex(m_X, m_Y);
 
             if (!m_HasExecuted)
             {
-                m_PreviousTile = currentTile;
+                m_PreviousTileIndex = currentTileIndex;
                 m_HasExecuted = true;
             }
 
-            if (currentTile == m_NewTile)
+            if (currentTileIndex == m_NewTileIndex)
                 return;
 
-            currentTile = m_NewTile;
+            layer.SetTileIndex(m_X, m_Y, m_NewTileIndex);
         }
 
         virtual void Undo(LayerStack& layerStack) override
         {
-            Tile& currentTile = layerStack.GetTile(m_X, m_Y, m_Index);
-            currentTile = m_PreviousTile;
+            layerStack.GetLayer(m_Index).SetTileIndex(m_X, m_Y, m_PreviousTileIndex);
         }
 
         virtual bool Validate(const Command& other) const override
@@ -41,13 +42,45 @@ namespace Tiles
             if (!otherCmd)
                 return false;
             return m_X == otherCmd->m_X && m_Y == otherCmd->m_Y &&
-                m_Index == otherCmd->m_Index && m_NewTile == otherCmd->m_NewTile;
+                m_Index == otherCmd->m_Index && m_NewTileIndex == otherCmd->m_NewTileIndex;
+        }
+
+        virtual size_t GetMemoryUsage() const override
+        {
+            return sizeof(*this);
+        }
+
+        virtual CommandType GetType() const override { return CommandType::TilePaint; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarInt(m_X);
+            writer.WriteVarInt(m_Y);
+            writer.WriteVarUInt(m_Index);
+            writer.WriteVarUInt(m_PreviousTileIndex);
+            writer.WriteVarUInt(m_NewTileIndex);
+            writer.WriteBool(m_HasExecuted);
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            int32_t x = static_cast<int32_t>(reader.ReadVarInt());
+            int32_t y = static_cast<int32_t>(reader.ReadVarInt());
+            size_t index = static_cast<size_t>(reader.ReadVarUInt());
+            uint16_t previousTileIndex = static_cast<uint16_t>(reader.ReadVarUInt());
+            uint16_t newTileIndex = static_cast<uint16_t>(reader.ReadVarUInt());
+
+            auto command = std::make_unique<TilePaintCommand>(x, y, index, newTileIndex);
+            command->m_PreviousTileIndex = previousTileIndex;
+            command->m_HasExecuted = reader.ReadBool();
+            return command;
         }
 
     private:
-        size_t m_X, m_Y, m_Index;
-        Tile m_PreviousTile;
-        Tile m_NewTile;
+        int32_t m_X, m_Y;
+        size_t m_Index;
+        uint16_t m_PreviousTileIndex = TilePalette::DEFAULT_INDEX;
+        uint16_t m_NewTileIndex;
         bool m_HasExecuted;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "Command.h"
+#include "../LayerStack.h"
+
+namespace Tiles
+{
+    // Group of commands undone and redone as a single history entry. Commands are executed as they
+    // are added, so each one sees the edits of the ones before it. Undo walks them in reverse.
+    class TransactionCommand : public Command
+    {
+    public:
+        // commandCount is a hint for the number of commands, storage for them is reserved up front
+        TransactionCommand(size_t commandCount = 0)
+        {
+            m_Commands.reserve(commandCount);
+        }
+
+        void Add(std::unique_ptr<Command> command, LayerStack& layerStack)
+        {
+            command->Execute(layerStack);
+            m_Commands.push_back(std::move(command));
+        }
+
+        // Reverts every added command and forgets them
+        void Abort(LayerStack& layerStack)
+        {
+            Undo(layerStack);
+            m_Commands.clear();
+        }
+
+        virtual void Execute(LayerStack& layerStack) override
+        {
+            for (const std::unique_ptr<Command>& command : m_Commands)
+            {
+                command->Execute(layerStack);
+            }
+        }
+
+        virtual void Undo(LayerStack& layerStack) override
+        {
+            for (auto command = m_Commands.rbegin(); command != m_Commands.rend(); ++command)
+            {
+                (*command)->Undo(layerStack);
+            }
+        }
+
+        virtual bool Validate(const Command& other) const override
+        {
+            return false;
+        }
+
+        virtual size_t GetMemoryUsage() const override
+        {
+            size_t memoryUsage = sizeof(*this) + m_Commands.capacity() * sizeof(std::unique_ptr<Command>);
+            for (const std::unique_ptr<Command>& command : m_Commands)
+            {
+                memoryUsage += command->GetMemoryUsage();
+            }
+            return memoryUsage;
+        }
+
+        virtual CommandType GetType() const override { return CommandType::Transaction; }
+
+        virtual void Serialize(ByteWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_Commands.size());
+            for (const std::unique_ptr<Command>& command : m_Commands)
+            {
+                Command::Write(*command, writer);
+            }
+        }
+
+        static std::unique_ptr<Command> Deserialize(ByteReader& reader, const LayerStack& layerStack)
+        {
+            // Every command takes at least its type byte, which bounds a corrupt count
+            size_t commandCount = static_cast<size_t>(reader.ReadVarUInt());
+            auto command = std::make_unique<TransactionCommand>(std::min<size_t>(commandCount, reader.GetRemaining()));
+            for (size_t i = 0; i < commandCount; i++)
+            {
+                command->m_Commands.push_back(Command::Read(reader, layerStack));
+            }
+            return command;
+        }
+
+        size_t GetCommandCount() const { return m_Commands.size(); }
+        bool IsEmpty() const { return m_Commands.empty(); }
+
+    private:
+        std::vector<std::unique_ptr<Command>> m_Commands;          // In execution order
+    };
+}
@@ -251,16 +251,23 @@ namespace Tiles
             static constexpr const char* Name = "tile_layer_name";
             static constexpr const char* Width = "tile_layer_width";
             static constexpr const char* Height = "tile_layer_height";
+            static constexpr const char* OriginX = "tile_layer_origin_x";
+            static constexpr const char* OriginY = "tile_layer_origin_y";
+            static constexpr const char* Unbounded = "tile_layer_unbounded";
             static constexpr const char* Visible = "tile_layer_visible";
             static constexpr const char* RenderGroup = "tile_layer_render_group";
             static constexpr const char* Tiles = "tile_layer_tiles";
+            static constexpr const char* TileIndices = "tile_layer_tile_indices";
+            static constexpr const char* TileRuns = "tile_layer_tile_runs";        // x, y, length, index for each run of painted tiles
         }
 
         namespace LayerStack
         {
             static constexpr const char* Width = "layer_stack_width";
             static constexpr const char* Height = "layer_stack_height";
+            static constexpr const char* Unbounded = "layer_stack_unbounded";
             static constexpr const char* TileLayers = "layer_stack_layers";
+            static constexpr const char* Palette = "layer_stack_palette";
 		}
 
         namespace Project
@@ -282,6 +289,7 @@ namespace Tiles
     {
         constexpr const char* ProjectExtension = ".tiles";
         constexpr const char* ProjectFilesFilter = "*.tiles";
+        constexpr const char* ProjectJSONExtension = ".json";
         constexpr const char* AllFilesFilter = "*.*";
 		constexpr const char* TextureFilesFilter = "*.png;*.jpg;*.jpeg";
     }
@@ -4,6 +4,10 @@
 #include "Commands/TileEraseCommand.h"
 #include "Commands/LayerFillCommand.h"
 
+#include "JsonWriter.h"
+#include "ProjectFile.h"
+#include "ProjectJSONReader.h"
+
 #include <algorithm>
 
 #include "json.hpp"
@@ -27,15 +31,22 @@ namespace Tiles
         m_Brush.SetPainted(true);
     }
 
+    Context::~Context()
+    {
+        // Only a crash leaves the journal behind for the next load to replay
+        m_Journal.Discard();
+    }
+
     void Context::InitializeSceneCamera()
     {
-        const auto& layerStack = m_Project->GetLayerStack();
-        const float gridWidth = static_cast<float>(layerStack.GetWidth());
-        const float gridHeight = static_cast<float>(layerStack.GetHeight());
+        // Unbounded projects center on their painted content
+        const TileBounds bounds = m_Project->GetLayerStack().GetBounds();
+        const float centerX = bounds.MinX + bounds.GetWidth() * 0.5f;
+        const float centerY = bounds.MinY + bounds.GetHeight() * 0.5f;
 
         m_ViewportCamera->SetPosition({
-            Viewport::Render::DefaultTileSize * (gridWidth * 0.5f),
-            Viewport::Render::DefaultTileSize * (gridHeight * 0.5f),
+            Viewport::Render::DefaultTileSize * centerX,
+            Viewport::Render::DefaultTileSize * centerY,
             1.0f
             });
 
@@ -50,8 +61,8 @@ namespace Tiles
     void Context::FitViewportCameraToProject()
     {
         const auto& layerStack = m_Project->GetLayerStack();
-        const float projectWidth = layerStack.GetWidth() * Viewport::Render::DefaultTileSize;
-        const float projectHeight = layerStack.GetHeight() * Viewport::Render::DefaultTileSize;
+        const float projectWidth = std::max(layerStack.GetWidth(), 1u) * Viewport::Render::DefaultTileSize;
+        const float projectHeight = std::max(layerStack.GetHeight(), 1u) * Viewport::Render::DefaultTileSize;
 
         CenterViewportCameraOnProject();
 
@@ -68,14 +79,14 @@ namespace Tiles
 
     void Context::CenterViewportCameraOnProject()
     {
-        const auto& layerStack = m_Project->GetLayerStack();
-        const float gridWidth = static_cast<float>(layerStack.GetWidth());
-        const float gridHeight = static_cast<float>(layerStack.GetHeight());
+        const TileBounds bounds = m_Project->GetLayerStack().GetBounds();
+        const float centerX = bounds.MinX + bounds.GetWidth() * 0.5f;
+        const float centerY = bounds.MinY + bounds.GetHeight() * 0.5f;
 
         glm::vec3 currentPos = m_ViewportCamera->GetPosition();
         m_ViewportCamera->SetPosition({
-            Viewport::Render::DefaultTileSize * (gridWidth * 0.5f),
-            Viewport::Render::DefaultTileSize * (gridHeight * 0.5f),
+            Viewport::Render::DefaultTileSize * centerX,
+            Viewport::Render::DefaultTileSize * centerY,
             currentPos.z
             });
     }
@@ -104,7 +115,7 @@ namespace Tiles
         return m_Project->GetLayerStack().GetLayer(m_WorkingLayer);
     }
 
-    void Context::PaintTile(size_t x, size_t y)
+    void Context::PaintTile(int32_t x, int32_t y)
     {
         if (HasWorkingLayer())
         {
@@ -112,7 +123,7 @@ namespace Tiles
         }
     }
 
-    void Context::PaintTileWithBrush(size_t x, size_t y, const Tile& brush)
+    void Context::PaintTileWithBrush(int32_t x, int32_t y, const Tile& brush)
     {
         if (HasWorkingLayer())
         {
@@ -120,76 +131,221 @@ namespace Tiles
         }
     }
 
-    void Context::PaintTileOnLayer(size_t layerIndex, size_t x, size_t y, const Tile& tile)
+    void Context::PaintTileOnLayer(size_t layerIndex, int32_t x, int32_t y, const Tile& tile)
     {
         LayerStack& layerStack = m_Project->GetLayerStack();
         if (!layerStack.IsValidLayerIndex(layerIndex))
             return;
 
+        // A full palette has no index for a new tile, the cell keeps what it has
+        uint16_t tileIndex;
+        if (!layerStack.GetPalette()->Intern(tile, tileIndex))
+            return;
+
         switch (m_PaintingMode)
         {
         case PaintingMode::Brush:
         {
-            auto command = std::make_unique<TilePaintCommand>(x, y, layerIndex, tile);
+            if (PaintStroke(layerIndex, x, y, tileIndex))
+                break;
+
+            auto command = std::make_unique<TilePaintCommand>(x, y, layerIndex, tileIndex);
             ExecuteCommand(std::move(command));
             break;
         }
         case PaintingMode::Eraser:
         {
+            if (PaintStroke(layerIndex, x, y, TilePalette::DEFAULT_INDEX))
+                break;
+
             auto command = std::make_unique<TileEraseCommand>(x, y, layerIndex);
             ExecuteCommand(std::move(command));
             break;
         }
         case PaintingMode::Fill:
         {
-            auto command = std::make_unique<LayerFillCommand>(x, y, layerIndex, tile);
+            auto command = std::make_unique<LayerFillCommand>(x, y, layerIndex, tileIndex);
             ExecuteCommand(std::move(command));
             break;
         }
         }
     }
 
-    void Context::EraseTile(size_t x, size_t y)
+    void Context::EraseTile(int32_t x, int32_t y)
     {
         if (HasWorkingLayer())
         {
+            if (PaintStroke(m_WorkingLayer, x, y, TilePalette::DEFAULT_INDEX))
+                return;
+
             auto command = std::make_unique<TileEraseCommand>(x, y, m_WorkingLayer);
             ExecuteCommand(std::move(command));
         }
     }
 
-    void Context::FillLayer(size_t x, size_t y)
+    void Context::FillLayer(int32_t x, int32_t y)
     {
         if (HasWorkingLayer())
         {
-            auto command = std::make_unique<LayerFillCommand>(x, y, m_WorkingLayer, m_Brush);
+            uint16_t tileIndex;
+            if (!m_Project->GetLayerStack().GetPalette()->Intern(m_Brush, tileIndex))
+                return;
+
+            auto command = std::make_unique<LayerFillCommand>(x, y, m_WorkingLayer, tileIndex);
             ExecuteCommand(std::move(command));
         }
     }
 
+    void Context::BeginStroke()
+    {
+        EndStroke();
+
+        if (HasWorkingLayer())
+        {
+            m_ActiveStroke = std::make_unique<StrokeCommand>(m_WorkingLayer);
+        }
+    }
+
+    void Context::EndStroke()
+    {
+        if (!m_ActiveStroke)
+            return;
+
+        // The cells are already on the layer, executing again only rewrites the same tiles
+        std::unique_ptr<StrokeCommand> stroke = std::move(m_ActiveStroke);
+        if (!stroke->IsEmpty())
+        {
+            stroke->Finish();
+            ExecuteCommand(std::move(stroke));
+        }
+    }
+
+    bool Context::PaintStroke(size_t layerIndex, int32_t x, int32_t y, uint16_t tileIndex)
+    {
+        if (!m_ActiveStroke || m_ActiveStroke->GetIndex() != layerIndex)
+            return false;
+
+        m_ActiveStroke->Paint(m_Project->GetLayerStack(), x, y, tileIndex);
+        m_Project->MarkAsModified();
+        return true;
+    }
+
+    void Context::BeginTransaction(size_t commandCount)
+    {
+        if (m_ActiveTransaction)
+        {
+            m_TransactionDepth++;
+            return;
+        }
+
+        EndStroke();
+
+        m_ActiveTransaction = std::make_unique<TransactionCommand>(commandCount);
+        m_TransactionDepth = 1;
+        m_TransactionAborted = false;
+    }
+
+    void Context::CommitTransaction()
+    {
+        if (!m_ActiveTransaction || --m_TransactionDepth > 0)
+            return;
+
+        EndTransaction();
+    }
+
+    void Context::AbortTransaction()
+    {
+        if (!m_ActiveTransaction)
+            return;
+
+        // Commands the enclosing levels still add are collected and reverted with the rest
+        m_TransactionAborted = true;
+        if (--m_TransactionDepth > 0)
+            return;
+
+        EndTransaction();
+    }
+
+    void Context::EndTransaction()
+    {
+        // A stroke started inside the transaction is part of it
+        EndStroke();
+
+        std::unique_ptr<TransactionCommand> transaction = std::move(m_ActiveTransaction);
+        if (m_TransactionAborted)
+        {
+            m_TransactionAborted = false;
+            if (m_Project)
+            {
+                transaction->Abort(m_Project->GetLayerStack());
+                ValidateWorkingLayer();
+            }
+            return;
+        }
+
+        if (transaction->IsEmpty() || !m_Project)
+            return;
+
+        // The commands already ran as they were added, the history only records the group
+        LayerStack& layerStack = m_Project->GetLayerStack();
+        if (const Command* committed = m_CommandHistory.Push(std::move(transaction)))
+        {
+            m_Journal.RecordExecute(*committed, layerStack);
+        }
+        m_Project->MarkAsModified();
+    }
+
     void Context::ExecuteCommand(std::unique_ptr<Command> command)
     {
+        if (command && m_Project && m_ActiveTransaction)
+        {
+            m_ActiveTransaction->Add(std::move(command), m_Project->GetLayerStack());
+            return;
+        }
+
         if (command && m_Project)
         {
-            m_CommandHistory.Execute(std::move(command), m_Project->GetLayerStack());
+            LayerStack& layerStack = m_Project->GetLayerStack();
+            if (const Command* executed = m_CommandHistory.Execute(std::move(command), layerStack))
+            {
+                m_Journal.RecordExecute(*executed, layerStack);
+            }
             m_Project->MarkAsModified();
         }
     }
 
     void Context::Undo()
     {
+        if (m_ActiveTransaction)
+            return;
+
+        EndStroke();
+
         if (CanUndo())
         {
-            m_CommandHistory.Undo(m_Project->GetLayerStack());
+            LayerStack& layerStack = m_Project->GetLayerStack();
+            if (const Command* undone = m_CommandHistory.Undo(layerStack))
+            {
+                m_Journal.RecordUndo(*undone, layerStack);
+            }
             m_Project->MarkAsModified();
         }
     }
 
     void Context::Redo()
     {
+        if (m_ActiveTransaction)
+            return;
+
+        EndStroke();
+
         if (CanRedo())
         {
-            m_CommandHistory.Redo(m_Project->GetLayerStack());
+            LayerStack& layerStack = m_Project->GetLayerStack();
+            if (const Command* redone = m_CommandHistory.Redo(layerStack))
+            {
+                m_Journal.RecordRedo(*redone, layerStack);
+            }
             m_Project->MarkAsModified();
         }
     }
@@ -211,10 +367,11 @@ namespace Tiles
         }
     }
 
-    void Context::CreateProject(const std::string& name, uint32_t width, uint32_t height)
+    void Context::CreateProject(const std::string& name, uint32_t width, uint32_t height, bool unbounded)
     {
-		m_CommandHistory.Clear();
-        m_Project = Lumina::CreateRef<Project>(width, height, name);
+		ClearHistory();
+        m_Journal.Discard();
+        m_Project = Lumina::CreateRef<Project>(width, height, name, unbounded);
         m_WorkingLayer = 0;
         m_PaintingMode = PaintingMode::None;
         m_Brush = Tile();
@@ -231,6 +388,9 @@ namespace Tiles
         if (m_Project->IsNew())
             return { false, "Project has no file path. Use 'Save As' to specify a location." };
 
+        if (NeedsSaveAs())
+            return { false, "Project was opened from JSON. Use 'Save As' to save it as a .tiles file." };
+
         auto path = m_Project->GetFilePath();
 
         auto directory = path.parent_path();
@@ -241,21 +401,12 @@ namespace Tiles
 
         try
         {
-            nlohmann::json projectJSON = m_Project->ToJSON();
-
-            std::ofstream file(path);
-
-            if (!file.is_open())
-            {
-                return { false, "Failed to open file for writing." };
-            }
-
-            file << projectJSON.dump(4);
-            file.close();
+            size_t droppedEntryCount = ProjectFile::Save(*m_Project, path);
 
             m_Project->MarkAsSaved();
             m_Project->UpdateLastAccessed();
 
+            m_Journal.Start(path, m_Project->GetLayerStack(), droppedEntryCount > 0);
             m_ProjectHistory.AddProject(path, m_Project->GetProjectName());
 
             LUMINA_LOG_INFO("Context::SaveProject: Successfully saved project '{}'", m_Project->GetProjectName());
@@ -283,22 +434,13 @@ namespace Tiles
 
         try
         {
-            nlohmann::json projectJSON = m_Project->ToJSON();
-
-            std::ofstream file(path);
-
-            if (!file.is_open())
-            {
-                return { false, "Failed to open file for writing." };
-            }
-
-            file << projectJSON.dump(4);
-            file.close();
+            size_t droppedEntryCount = ProjectFile::Save(*m_Project, path);
 
             m_Project->SetFilePath(path.string());
             m_Project->MarkAsSaved();
             m_Project->UpdateLastAccessed();
 
+            m_Journal.Start(path, m_Project->GetLayerStack(), droppedEntryCount > 0);
             m_ProjectHistory.AddProject(path, m_Project->GetProjectName());
 
             LUMINA_LOG_INFO("Context::SaveProjectAs: Successfully saved project '{}' to '{}'", m_Project->GetProjectName(), path.string());
@@ -310,6 +452,46 @@ namespace Tiles
         }
     }
 
+    ProjectResult Context::ExportProjectJSON(const std::filesystem::path& path, bool pretty) const
+    {
+        if (!m_Project)
+            return { false, "No project loaded." };
+
+        if (path.empty())
+            return { false, "Invalid file path." };
+
+        // A project opened from JSON would be overwritten, and the journal started against it lost
+        std::error_code error;
+        if (!m_Project->IsNew() && std::filesystem::equivalent(path, m_Project->GetFilePath(), error))
+            return { false, "Export would overwrite the project file. Use 'Save As' to save the project as a .tiles file first." };
+
+        try
+        {
+            std::ofstream file(path);
+            if (!file.is_open())
+            {
+                return { false, "Failed to open file for writing." };
+            }
+
+            JsonWriter writer(file, pretty);
+            m_Project->WriteJSON(writer);
+            writer.Flush();
+
+            file.close();
+            if (!file)
+            {
+                return { false, "Failed to write file." };
+            }
+
+            LUMINA_LOG_INFO("Context::ExportProjectJSON: Exported project '{}' to '{}'", m_Project->GetProjectName(), path.string());
+            return { true, "Project exported successfully." };
+        }
+        catch (const std::exception& e)
+        {
+            return { false, std::string("Failed to export project: ") + e.what() };
+        }
+    }
+
     ProjectResult Context::LoadProject(const std::filesystem::path& path)
     {
         if (!std::filesystem::exists(path))
@@ -324,36 +506,45 @@ namespace Tiles
 
         try
         {
-			std::ifstream file(path);
-            if (!file.is_open())
+            // Projects saved before the binary format, and JSON exports, are still opened as JSON
+            if (ProjectFile::IsBinary(path))
             {
-                return { false, "Failed to open file for reading." };
+                project = ProjectFile::Load(path);
             }
+            else
+            {
+                std::ifstream file(path);
+                if (!file.is_open())
+                {
+                    return { false, "Failed to open file for reading." };
+                }
 
-            nlohmann::json jsonProject;
-            file >> jsonProject;
-            file.close();
-            
-            project = Project::FromJSON(jsonProject);
+                project = ProjectJSONReader::Load(file);
+            }
             
             project->SetFilePath(path.string());
             project->MarkAsSaved();
             project->UpdateLastAccessed();
         }
-        catch (const nlohmann::json::parse_error& e)
-        {
-            LUMINA_LOG_INFO("Context::LoadProject: JSON parse error: {}", e.what());
-            return { false, std::string("Invalid project file format: ") + e.what() };
-        }
         catch (const std::exception& e)
         {
             LUMINA_LOG_INFO("Context::LoadProject: Load failed: {}", e.what());
             return { false, std::string("Failed to load project: ") + e.what() };
         }
 
+        // The project being replaced was not saved, its journal must not come back on the next load
+        m_Journal.Discard();
 		m_Project = project;
 
-        m_CommandHistory.Clear();
+        ClearHistory();
+
+        // Edits that never made it into a save are replayed from the journal
+        size_t recoveredCount = m_Journal.Resume(path, *m_Project);
+        if (recoveredCount > 0)
+        {
+            m_Project->MarkAsModified();
+            LUMINA_LOG_INFO("Context::LoadProject: Recovered {} unsaved edits of '{}'", recoveredCount, path.string());
+        }
 
         m_WorkingLayer = 0;
         m_PaintingMode = PaintingMode::None;
@@ -375,11 +566,18 @@ namespace Tiles
         if (!m_Project)
             return;
 
+        if (m_Project->GetLayerStack().IsUnbounded())
+        {
+            LUMINA_LOG_INFO("Context::ResizeProject: Project '{}' is unbounded and cannot be resized", m_Project->GetProjectName());
+            return;
+        }
+
         const auto& layerStack = m_Project->GetLayerStack();
         const float oldWidth = static_cast<float>(layerStack.GetWidth());
         const float oldHeight = static_cast<float>(layerStack.GetHeight());
 
         m_Project->GetLayerStack().Resize(width, height);
+        m_Journal.RecordResize(width, height);
         m_Project->MarkAsModified();
         ValidateWorkingLayer();
 
@@ -399,6 +597,72 @@ namespace Tiles
 		m_Project->UpdateLastAccessed();
     }
 
+    void Context::AddTextureAtlas(const Ref<Lumina::TextureAtlas>& atlas)
+    {
+        if (!m_Project || !atlas)
+            return;
+
+        if (!m_Project->CanAddTextureAtlas())
+        {
+            LUMINA_LOG_INFO("Context::AddTextureAtlas: Project already holds {} texture atlases", PackedTile::MAX_ATLAS_COUNT);
+            return;
+        }
+
+        m_Journal.RecordAtlasAdd(*m_Project, *atlas);
+        m_Project->AddTextureAtlas(atlas);
+    }
+
+    void Context::RemoveTextureAtlas(size_t index)
+    {
+        if (!m_Project || index >= m_Project->GetTextureAtlasCount() || !CanChangeTextureAtlases())
+            return;
+
+        m_Journal.RecordAtlasRemove(*m_Project, index);
+        m_Project->RemoveTextureAtlas(index);
+    }
+
+    void Context::MoveTextureAtlas(size_t fromIndex, size_t toIndex)
+    {
+        size_t atlasCount = m_Project ? m_Project->GetTextureAtlasCount() : 0;
+        if (fromIndex >= atlasCount || toIndex >= atlasCount || fromIndex == toIndex || !CanChangeTextureAtlases())
+            return;
+
+        m_Journal.RecordAtlasMove(*m_Project, fromIndex, toIndex);
+        m_Project->MoveTextureAtlas(fromIndex, toIndex);
+    }
+
+    void Context::ClearTextureAtlases()
+    {
+        if (!m_Project || !CanChangeTextureAtlases())
+            return;
+
+        m_Journal.RecordAtlasClear(*m_Project);
+        m_Project->ClearTextureAtlases();
+    }
+
+    void Context::UpdateTextureAtlas(size_t index)
+    {
+        if (!m_Project || index >= m_Project->GetTextureAtlasCount())
+            return;
+
+        m_Journal.RecordAtlasUpdate(*m_Project, index);
+        m_Project->MarkAsModified();
+    }
+
+    bool Context::CanChangeTextureAtlases()
+    {
+        // Commands of an open transaction reach the journal at the commit, after the atlas change
+        // that remapped their tiles, so the replay would apply them in the wrong order
+        if (m_ActiveTransaction)
+        {
+            LUMINA_LOG_INFO("Context::CanChangeTextureAtlases: Texture atlases can't be removed or moved during a transaction");
+            return false;
+        }
+
+        EndStroke();
+        return true;
+    }
+
     std::string Context::GetProjectDisplayName() const
     {
         if (!m_Project)
@@ -5,6 +5,9 @@
 #include "Tile.h"
 #include "Project.h"
 #include "CommandHistory.h"
+#include "EditJournal.h"
+#include "Commands/StrokeCommand.h"
+#include "Commands/TransactionCommand.h"
 #include "ProjectHistory.h"
 
 #include "Constants.h"
@@ -35,7 +38,7 @@ namespace Tiles
         static Ref<Context> Create();
 
         Context();
-        ~Context() = default;
+        ~Context();
 
         Ref<Lumina::OrthographicCamera> GetViewportCamera() { return m_ViewportCamera; }
         const Ref<Lumina::OrthographicCamera> GetViewportCamera() const { return m_ViewportCamera; }
@@ -55,28 +58,58 @@ namespace Tiles
         const Tile& GetBrush() const { return m_Brush; }
         Tile& GetBrush() { return m_Brush; }
 
-        void PaintTile(size_t x, size_t y);
-        void PaintTileWithBrush(size_t x, size_t y, const Tile& brush);
-        void PaintTileOnLayer(size_t layerIndex, size_t x, size_t y, const Tile& tile);
-        void EraseTile(size_t x, size_t y);
-        void FillLayer(size_t x, size_t y);
+        void PaintTile(int32_t x, int32_t y);
+        void PaintTileWithBrush(int32_t x, int32_t y, const Tile& brush);
+        void PaintTileOnLayer(size_t layerIndex, int32_t x, int32_t y, const Tile& tile);
+        void EraseTile(int32_t x, int32_t y);
+        void FillLayer(int32_t x, int32_t y);
+
+        // Brush and eraser input between BeginStroke and EndStroke becomes a single undo entry
+        void BeginStroke();
+        void EndStroke();
+        bool IsStroking() const { return m_ActiveStroke != nullptr; }
+
+        // Commands executed between BeginTransaction and CommitTransaction become a single undo entry.
+        // Transactions nest, only the outermost commit reaches the history. An abort at any level
+        // reverts everything since the outermost BeginTransaction once the outermost level ends,
+        // whether by commit or abort, including commands executed after the abort. Undo and redo
+        // wait until then.
+        void BeginTransaction(size_t commandCount = 0);
+        void CommitTransaction();
+        void AbortTransaction();
+        bool IsInTransaction() const { return m_ActiveTransaction != nullptr; }
 
         void ExecuteCommand(std::unique_ptr<Command> command);
         bool CanUndo() const { return m_CommandHistory.CanUndo(); }
         bool CanRedo() const { return m_CommandHistory.CanRedo(); }
+        const CommandHistory& GetCommandHistory() const { return m_CommandHistory; }
         void Undo();
         void Redo();
 
         bool IsDirty() const { return m_Project->HasUnsavedChanges(); }
 
-		void ClearHistory() { m_CommandHistory.Clear(); }   
+		void ClearHistory() { m_ActiveStroke.reset(); m_ActiveTransaction.reset(); m_TransactionDepth = 0; m_TransactionAborted = false; m_CommandHistory.Clear(); }   
 
 		// Project Management
-        void CreateProject(const std::string& name, uint32_t width, uint32_t height);
+        void CreateProject(const std::string& name, uint32_t width, uint32_t height, bool unbounded = false);
         ProjectResult SaveProject();
+        // Save only writes binary projects, one opened from a JSON file has to pick a .tiles path first
+        bool NeedsSaveAs() const { return m_Project && !m_Project->IsNew() && m_Project->GetFilePath().extension() != File::ProjectExtension; }
         ProjectResult SaveProjectAs(const std::filesystem::path& path);
         ProjectResult LoadProject(const std::filesystem::path& path);
+        // Projects are saved in the binary format, JSON is kept for other tools and opens like a project.
+        // Pretty output is indented and noticeably larger. Refuses to overwrite the project's own file.
+        ProjectResult ExportProjectJSON(const std::filesystem::path& path, bool pretty = false) const;
         void ResizeProject(uint32_t width, uint32_t height);
+
+        // Changes to the atlas list rewrite palette entries, so they go through here to reach the journal.
+        // UpdateTextureAtlas records an atlas whose texture or size was changed in place.
+        void AddTextureAtlas(const Ref<Lumina::TextureAtlas>& atlas);
+        void RemoveTextureAtlas(size_t index);
+        void MoveTextureAtlas(size_t fromIndex, size_t toIndex);
+        void ClearTextureAtlases();
+        void UpdateTextureAtlas(size_t index);
+
         bool HasProject() const { return m_Project != nullptr; }
         std::string GetProjectDisplayName() const;
         Ref<Project> GetProject() { return m_Project; }
@@ -90,10 +123,18 @@ namespace Tiles
 
     private:
         void ValidateWorkingLayer();
+        void EndTransaction();
+        bool CanChangeTextureAtlases();
+        bool PaintStroke(size_t layerIndex, int32_t x, int32_t y, uint16_t tileIndex);
         void InitializeSceneCamera();
 
     private: 
         CommandHistory m_CommandHistory;
+        EditJournal m_Journal;
+        std::unique_ptr<StrokeCommand> m_ActiveStroke;
+        std::unique_ptr<TransactionCommand> m_ActiveTransaction;
+        size_t m_TransactionDepth = 0;
+        bool m_TransactionAborted = false;
         ProjectHistory m_ProjectHistory; 
 
         Ref<Project> m_Project;
@@ -0,0 +1,523 @@
+#include "EditJournal.h"
+
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Lumina/Core/Log.h"
+
+namespace Tiles
+{
+    namespace
+    {
+        constexpr uint32_t JOURNAL_MAGIC = 0x4C4E4A54;         // "TJNL"
+        constexpr uint8_t JOURNAL_VERSION = 1;
+        constexpr size_t RECORD_HEADER_SIZE = 8;                // Body size and checksum
+
+        // FNV-1a, only meant to catch records torn by a crash
+        uint32_t GetChecksum(const uint8_t* data, size_t size)
+        {
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i < size; i++)
+            {
+                hash = (hash ^ data[i]) * 16777619u;
+            }
+            return hash;
+        }
+
+        // Identifies the saved file a journal was started against
+        struct ProjectStamp
+        {
+            uint64_t FileSize = 0;
+            uint64_t WriteTime = 0;
+
+            bool operator==(const ProjectStamp& other) const { return FileSize == other.FileSize && WriteTime == other.WriteTime; }
+        };
+
+        bool GetProjectStamp(const std::filesystem::path& projectPath, ProjectStamp& stamp)
+        {
+            std::error_code error;
+            stamp.FileSize = std::filesystem::file_size(projectPath, error);
+            if (error)
+                return false;
+
+            auto writeTime = std::filesystem::last_write_time(projectPath, error);
+            if (error)
+                return false;
+
+            stamp.WriteTime = static_cast<uint64_t>(writeTime.time_since_epoch().count());
+            return true;
+        }
+
+        void WritePackedTile(ByteWriter& writer, const PackedTile& tile)
+        {
+            for (uint16_t textureCoord : tile.TextureCoords)
+            {
+                writer.WriteVarUInt(textureCoord);
+            }
+            writer.WriteU32(tile.Tint);
+            writer.WriteU8(tile.AtlasIndex);
+            writer.WriteU8(tile.Flags);
+            writer.WriteU8(tile.Size[0]);
+            writer.WriteU8(tile.Size[1]);
+        }
+
+        PackedTile ReadPackedTile(ByteReader& reader)
+        {
+            PackedTile tile;
+            for (uint16_t& textureCoord : tile.TextureCoords)
+            {
+                textureCoord = static_cast<uint16_t>(reader.ReadVarUInt());
+            }
+            tile.Tint = reader.ReadU32();
+            tile.AtlasIndex = reader.ReadU8();
+            tile.Flags = reader.ReadU8();
+            tile.Size[0] = reader.ReadU8();
+            tile.Size[1] = reader.ReadU8();
+            return tile;
+        }
+
+        // Atlases without a texture are stored with an empty path
+        void WriteAtlas(ByteWriter& writer, const Lumina::TextureAtlas& atlas)
+        {
+            writer.WriteString(atlas.HasTexture() ? atlas.GetTexture()->GetPath() : std::string());
+            writer.WriteVarUInt(static_cast<uint64_t>(atlas.GetWidth()));
+            writer.WriteVarUInt(static_cast<uint64_t>(atlas.GetHeight()));
+        }
+
+        // Atlas indices in a record only hold for the atlases it was recorded against
+        void CheckAtlasCount(ByteReader& reader, const Project& project, size_t requiredCount = 0)
+        {
+            size_t atlasCount = static_cast<size_t>(reader.ReadVarUInt());
+            if (atlasCount != project.GetTextureAtlasCount() || atlasCount < requiredCount)
+                throw std::runtime_error("Texture atlases no longer match the journal");
+        }
+    }
+
+    bool EditJournal::Start(const std::filesystem::path& projectPath, const LayerStack& layerStack, bool paletteCompacted)
+    {
+        std::filesystem::path previousPath = m_Path;
+        Close();
+
+        std::filesystem::path journalPath = GetJournalPath(projectPath);
+        if (!previousPath.empty() && previousPath != journalPath)
+        {
+            std::error_code error;
+            std::filesystem::remove(previousPath, error);
+        }
+
+        ProjectStamp stamp;
+        if (!GetProjectStamp(projectPath, stamp))
+        {
+            LUMINA_LOG_INFO("EditJournal::Start: Could not read '{}', edits are not journaled", projectPath.string());
+            return false;
+        }
+
+        m_File.open(journalPath, std::ios::binary | std::ios::trunc);
+        if (!m_File.is_open())
+        {
+            LUMINA_LOG_INFO("EditJournal::Start: Could not create '{}', edits are not journaled", journalPath.string());
+            return false;
+        }
+
+        m_Path = journalPath;
+        m_PaletteEntryCount = layerStack.GetPalette()->GetEntryCount();
+
+        // Written lazily, a journal without edits must not undo the compaction on the next load
+        if (paletteCompacted)
+        {
+            const TilePalette& palette = *layerStack.GetPalette();
+            for (size_t i = 1; i < palette.GetEntryCount(); i++)
+            {
+                m_PendingLayout.push_back(palette.GetPackedTile(static_cast<uint16_t>(i)));
+            }
+        }
+
+        ByteWriter header;
+        header.WriteU32(JOURNAL_MAGIC);
+        header.WriteU8(JOURNAL_VERSION);
+        header.WriteU64(stamp.FileSize);
+        header.WriteU64(stamp.WriteTime);
+        m_File.write(reinterpret_cast<const char*>(header.GetBytes().data()), static_cast<std::streamsize>(header.GetSize()));
+        m_File.flush();
+
+        return static_cast<bool>(m_File);
+    }
+
+    size_t EditJournal::Resume(const std::filesystem::path& projectPath, Project& project)
+    {
+        Close();
+
+        LayerStack& layerStack = project.GetLayerStack();
+
+        std::filesystem::path journalPath = GetJournalPath(projectPath);
+        std::ifstream file(journalPath, std::ios::binary);
+        if (!file.is_open())
+        {
+            Start(projectPath, layerStack);
+            return 0;
+        }
+
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+
+        ByteReader reader(bytes);
+        ProjectStamp journalStamp;
+        ProjectStamp projectStamp;
+        try
+        {
+            if (reader.ReadU32() != JOURNAL_MAGIC || reader.ReadU8() != JOURNAL_VERSION)
+                throw std::runtime_error("Not a journal");
+
+            journalStamp.FileSize = reader.ReadU64();
+            journalStamp.WriteTime = reader.ReadU64();
+        }
+        catch (const std::exception&)
+        {
+            journalStamp = {};
+        }
+
+        if (!GetProjectStamp(projectPath, projectStamp) || !(journalStamp == projectStamp))
+        {
+            LUMINA_LOG_INFO("EditJournal::Resume: '{}' does not match the saved project, discarding it", journalPath.string());
+            Start(projectPath, layerStack);
+            return 0;
+        }
+
+        size_t validSize = reader.GetPosition();
+        size_t replayedCount = 0;
+        try
+        {
+            while (reader.GetRemaining() >= RECORD_HEADER_SIZE)
+            {
+                uint32_t size = reader.ReadU32();
+                uint32_t checksum = reader.ReadU32();
+                if (size > reader.GetRemaining())
+                    break;
+
+                const uint8_t* body = reader.Skip(size);
+                if (GetChecksum(body, size) != checksum)
+                    break;
+
+                ByteReader recordReader(body, size);
+                Replay(recordReader, project);
+
+                validSize = reader.GetPosition();
+                replayedCount++;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            LUMINA_LOG_INFO("EditJournal::Resume: Stopped replaying '{}': {}", journalPath.string(), e.what());
+        }
+
+        if (validSize < bytes.size())
+        {
+            LUMINA_LOG_INFO("EditJournal::Resume: Dropping {} unreadable bytes at the end of '{}'", bytes.size() - validSize, journalPath.string());
+        }
+
+        // New records go right after the last good one
+        std::error_code error;
+        std::filesystem::resize_file(journalPath, validSize, error);
+        m_File.open(journalPath, std::ios::binary | std::ios::app);
+        if (error || !m_File.is_open())
+        {
+            LUMINA_LOG_INFO("EditJournal::Resume: Could not reopen '{}', edits are not journaled", journalPath.string());
+            m_File.close();
+            return replayedCount;
+        }
+
+        m_Path = journalPath;
+        m_PaletteEntryCount = layerStack.GetPalette()->GetEntryCount();
+        return replayedCount;
+    }
+
+    void EditJournal::Close()
+    {
+        if (m_File.is_open())
+        {
+            m_File.close();
+        }
+        m_Path.clear();
+        m_PaletteEntryCount = 0;
+        m_PendingLayout.clear();
+    }
+
+    void EditJournal::Discard()
+    {
+        std::filesystem::path path = m_Path;
+        Close();
+
+        if (!path.empty())
+        {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+        }
+    }
+
+    void EditJournal::RecordResize(uint32_t width, uint32_t height)
+    {
+        if (!IsOpen())
+            return;
+
+        ByteWriter record;
+        record.WriteU8(static_cast<uint8_t>(RecordType::Resize));
+        record.WriteVarUInt(width);
+        record.WriteVarUInt(height);
+        Append(record);
+    }
+
+    void EditJournal::RecordAtlasAdd(const Project& project, const Lumina::TextureAtlas& atlas)
+    {
+        if (!IsOpen())
+            return;
+
+        ByteWriter record = BeginAtlasRecord(RecordType::AtlasAdd, project);
+        WriteAtlas(record, atlas);
+        Append(record);
+    }
+
+    void EditJournal::RecordAtlasRemove(const Project& project, size_t index)
+    {
+        if (!IsOpen())
+            return;
+
+        ByteWriter record = BeginAtlasRecord(RecordType::AtlasRemove, project);
+        record.WriteVarUInt(index);
+        Append(record);
+    }
+
+    void EditJournal::RecordAtlasMove(const Project& project, size_t fromIndex, size_t toIndex)
+    {
+        if (!IsOpen())
+            return;
+
+        ByteWriter record = BeginAtlasRecord(RecordType::AtlasMove, project);
+        record.WriteVarUInt(fromIndex);
+        record.WriteVarUInt(toIndex);
+        Append(record);
+    }
+
+    void EditJournal::RecordAtlasClear(const Project& project)
+    {
+        if (!IsOpen())
+            return;
+
+        ByteWriter record = BeginAtlasRecord(RecordType::AtlasClear, project);
+        Append(record);
+    }
+
+    void EditJournal::RecordAtlasUpdate(const Project& project, size_t index)
+    {
+        if (!IsOpen())
+            return;
+
+        ByteWriter record = BeginAtlasRecord(RecordType::AtlasUpdate, project);
+        record.WriteVarUInt(index);
+        WriteAtlas(record, *project.GetTextureAtlases()[index]);
+        Append(record);
+    }
+
+    std::filesystem::path EditJournal::GetJournalPath(const std::filesystem::path& projectPath)
+    {
+        std::filesystem::path journalPath = projectPath;
+        journalPath += ".journal";
+        return journalPath;
+    }
+
+    void EditJournal::RecordCommand(RecordType type, const Command& command, const LayerStack& layerStack)
+    {
+        if (!IsOpen())
+            return;
+
+        RecordPaletteEntries(layerStack);
+
+        ByteWriter record;
+        record.WriteU8(static_cast<uint8_t>(type));
+        Command::Write(command, record);
+        Append(record);
+    }
+
+    void EditJournal::RecordPaletteEntries(const LayerStack& layerStack)
+    {
+        const TilePalette& palette = *layerStack.GetPalette();
+        size_t entryCount = palette.GetEntryCount();
+        if (entryCount <= m_PaletteEntryCount)
+            return;
+
+        ByteWriter record;
+        record.WriteU8(static_cast<uint8_t>(RecordType::Palette));
+        record.WriteVarUInt(m_PaletteEntryCount);
+        record.WriteVarUInt(entryCount - m_PaletteEntryCount);
+        for (size_t i = m_PaletteEntryCount; i < entryCount; i++)
+        {
+            WritePackedTile(record, palette.GetPackedTile(static_cast<uint16_t>(i)));
+        }
+        Append(record);
+
+        m_PaletteEntryCount = entryCount;
+    }
+
+    ByteWriter EditJournal::BeginAtlasRecord(RecordType type, const Project& project)
+    {
+        // Entries not yet journaled go first, still pointing at the atlases they were made with
+        RecordPaletteEntries(project.GetLayerStack());
+
+        ByteWriter record;
+        record.WriteU8(static_cast<uint8_t>(type));
+        record.WriteVarUInt(project.GetTextureAtlasCount());
+        return record;
+    }
+
+    void EditJournal::Append(const ByteWriter& record)
+    {
+        if (!m_PendingLayout.empty())
+        {
+            ByteWriter layout;
+            layout.WriteU8(static_cast<uint8_t>(RecordType::PaletteLayout));
+            layout.WriteVarUInt(m_PendingLayout.size());
+            for (const PackedTile& tile : m_PendingLayout)
+            {
+                WritePackedTile(layout, tile);
+            }
+            m_PendingLayout.clear();
+            Append(layout);
+
+            if (!IsOpen())
+                return;
+        }
+
+        const std::vector<uint8_t>& body = record.GetBytes();
+
+        ByteWriter header;
+        header.WriteU32(static_cast<uint32_t>(body.size()));
+        header.WriteU32(GetChecksum(body.data(), body.size()));
+
+        // One flush per record hands it to the operating system, so an editor crash can't lose it
+        m_File.write(reinterpret_cast<const char*>(header.GetBytes().data()), static_cast<std::streamsize>(header.GetSize()));
+        m_File.write(reinterpret_cast<const char*>(body.data()), static_cast<std::streamsize>(body.size()));
+        m_File.flush();
+
+        if (!m_File)
+        {
+            LUMINA_LOG_INFO("EditJournal::Append: Failed to write to '{}', edits are no longer journaled", m_Path.string());
+            Close();
+        }
+    }
+
+    void EditJournal::Replay(ByteReader& reader, Project& project)
+    {
+        LayerStack& layerStack = project.GetLayerStack();
+        RecordType type = static_cast<RecordType>(reader.ReadU8());
+        switch (type)
+        {
+        case RecordType::Palette:
+        {
+            size_t firstIndex = static_cast<size_t>(reader.ReadVarUInt());
+            size_t count = static_cast<size_t>(reader.ReadVarUInt());
+            TilePalette& palette = *layerStack.GetPalette();
+            for (size_t i = 0; i < count; i++)
+            {
+                // Commands store raw indices, so every entry has to land where it was when recorded
+                uint16_t tileIndex;
+                if (!palette.Intern(ReadPackedTile(reader), tileIndex) || tileIndex != firstIndex + i)
+                    throw std::runtime_error("Palette no longer matches the journal");
+            }
+            break;
+        }
+        case RecordType::Execute:
+        case RecordType::Redo:
+            Command::Read(reader, layerStack)->Execute(layerStack);
+            break;
+        case RecordType::Undo:
+            Command::Read(reader, layerStack)->Undo(layerStack);
+            break;
+        case RecordType::Resize:
+        {
+            uint32_t width = static_cast<uint32_t>(reader.ReadVarUInt());
+            uint32_t height = static_cast<uint32_t>(reader.ReadVarUInt());
+            layerStack.Resize(width, height);
+            break;
+        }
+        case RecordType::PaletteLayout:
+        {
+            // The saved file left out unused entries, layers go back to the numbering commands were recorded with
+            size_t count = static_cast<size_t>(reader.ReadVarUInt());
+            if (count >= TilePalette::MAX_ENTRY_COUNT)
+                throw std::runtime_error("Palette layout too large");
+
+            std::vector<PackedTile> entries(count);
+            for (PackedTile& entry : entries)
+            {
+                entry = ReadPackedTile(reader);
+            }
+
+            Ref<TilePalette> palette = TilePalette::FromPackedTiles(entries.data(), entries.size());
+            if (!layerStack.SetPalette(palette) || palette->GetEntryCount() != count + 1)
+                throw std::runtime_error("Palette layout does not match the saved project");
+            break;
+        }
+        case RecordType::AtlasAdd:
+        {
+            CheckAtlasCount(reader, project);
+            std::string texturePath = reader.ReadString();
+            int32_t width = static_cast<int32_t>(reader.ReadVarUInt());
+            int32_t height = static_cast<int32_t>(reader.ReadVarUInt());
+
+            // Unlike a load, a missing atlas can't be skipped, later records count on its index
+            auto atlas = texturePath.empty() ? Lumina::TextureAtlas::Create(width, height) : Lumina::TextureAtlas::Create(texturePath, width, height);
+            if (!atlas)
+                throw std::runtime_error("Failed to create texture atlas from path: " + texturePath);
+            if (!project.CanAddTextureAtlas())
+                throw std::runtime_error("Too many texture atlases");
+            project.AddTextureAtlas(atlas);
+            break;
+        }
+        case RecordType::AtlasRemove:
+        {
+            CheckAtlasCount(reader, project, 1);
+            size_t index = static_cast<size_t>(reader.ReadVarUInt());
+            if (index >= project.GetTextureAtlasCount())
+                throw std::runtime_error("Texture atlas index out of range");
+            project.RemoveTextureAtlas(index);
+            break;
+        }
+        case RecordType::AtlasMove:
+        {
+            CheckAtlasCount(reader, project, 1);
+            size_t fromIndex = static_cast<size_t>(reader.ReadVarUInt());
+            size_t toIndex = static_cast<size_t>(reader.ReadVarUInt());
+            if (fromIndex >= project.GetTextureAtlasCount() || toIndex >= project.GetTextureAtlasCount())
+                throw std::runtime_error("Texture atlas index out of range");
+            project.MoveTextureAtlas(fromIndex, toIndex);
+            break;
+        }
+        case RecordType::AtlasClear:
+            CheckAtlasCount(reader, project);
+            project.ClearTextureAtlases();
+            break;
+        case RecordType::AtlasUpdate:
+        {
+            CheckAtlasCount(reader, project, 1);
+            size_t index = static_cast<size_t>(reader.ReadVarUInt());
+            if (index >= project.GetTextureAtlasCount())
+                throw std::runtime_error("Texture atlas index out of range");
+
+            std::string texturePath = reader.ReadString();
+            int32_t width = static_cast<int32_t>(reader.ReadVarUInt());
+            int32_t height = static_cast<int32_t>(reader.ReadVarUInt());
+
+            Ref<Lumina::TextureAtlas> atlas = project.GetTextureAtlas(index);
+            if (texturePath.empty())
+                atlas->RemoveTexture();
+            else if (!atlas->HasTexture() || atlas->GetTexture()->GetPath() != texturePath)
+                atlas->SetTexture(texturePath);
+            atlas->Resize(width, height);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown journal record");
+        }
+    }
+}
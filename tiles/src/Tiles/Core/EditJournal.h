@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "ByteStream.h"
+#include "LayerStack.h"
+#include "Project.h"
+
+#include "Commands/Command.h"
+
+namespace Tiles
+{
+    // Append-only log of the edits made since a project was last saved, kept next to the project
+    // file as "<project>.journal". Every executed, undone and redone command is appended in its
+    // Command::Serialize form, together with the palette entries it may reference, and so is every
+    // change to the texture atlases, whose removal and reordering rewrite palette entries. A crash
+    // loses nothing that made it into the journal. Saving starts a new, empty journal, leaving the
+    // project without saving discards it, so only a crash leaves one behind to replay.
+    //
+    // Each record carries its size and a checksum. A record torn by a crash fails the check and
+    // ends the replay, everything before it is still recovered.
+    class EditJournal
+    {
+    public:
+        EditJournal() = default;
+        ~EditJournal() { Close(); }
+
+        EditJournal(const EditJournal&) = delete;
+        EditJournal& operator=(const EditJournal&) = delete;
+
+        // Starts an empty journal for the project just saved to projectPath. The journal being
+        // written so far is removed, its edits are part of that save. When the save left unused
+        // palette entries out (see ProjectFile::Save), the in-memory palette is recorded ahead of the
+        // first edit, so replayed commands find their tiles under the indices they were recorded with.
+        bool Start(const std::filesystem::path& projectPath, const LayerStack& layerStack, bool paletteCompacted = false);
+
+        // Replays the journal next to projectPath onto the project just loaded from it and keeps
+        // appending to it. A journal written against another version of the file is discarded.
+        // Returns the number of records replayed.
+        size_t Resume(const std::filesystem::path& projectPath, Project& project);
+
+        // Stops journaling, the file stays on disk so its edits can still be recovered
+        void Close();
+
+        // Stops journaling and removes the file, for edits the user chose not to save
+        void Discard();
+
+        bool IsOpen() const { return m_File.is_open(); }
+
+        void RecordExecute(const Command& command, const LayerStack& layerStack) { RecordCommand(RecordType::Execute, command, layerStack); }
+        void RecordUndo(const Command& command, const LayerStack& layerStack) { RecordCommand(RecordType::Undo, command, layerStack); }
+        void RecordRedo(const Command& command, const LayerStack& layerStack) { RecordCommand(RecordType::Redo, command, layerStack); }
+        void RecordResize(uint32_t width, uint32_t height);
+
+        // Called before the matching Project call, replay then remaps the palette the same way
+        void RecordAtlasAdd(const Project& project, const Lumina::TextureAtlas& atlas);
+        void RecordAtlasRemove(const Project& project, size_t index);
+        void RecordAtlasMove(const Project& project, size_t fromIndex, size_t toIndex);
+        void RecordAtlasClear(const Project& project);
+
+        // Called after the texture or size of an atlas changed in place
+        void RecordAtlasUpdate(const Project& project, size_t index);
+
+        static std::filesystem::path GetJournalPath(const std::filesystem::path& projectPath);
+
+    private:
+        enum class RecordType : uint8_t
+        {
+            Palette = 0,
+            Execute,
+            Undo,
+            Redo,
+            Resize,
+            PaletteLayout,                          // Every palette entry, in memory order
+            AtlasAdd,                               // Atlas records start with the atlas count they were made against
+            AtlasRemove,
+            AtlasMove,
+            AtlasClear,
+            AtlasUpdate
+        };
+
+        void RecordCommand(RecordType type, const Command& command, const LayerStack& layerStack);
+
+        // Writes the palette entries added since the last record, commands may refer to them
+        void RecordPaletteEntries(const LayerStack& layerStack);
+
+        ByteWriter BeginAtlasRecord(RecordType type, const Project& project);
+
+        void Append(const ByteWriter& record);
+
+        static void Replay(ByteReader& reader, Project& project);
+
+    private:
+        std::filesystem::path m_Path;               // Journal being written, empty when closed
+        std::ofstream m_File;                       // Opened for appending
+        size_t m_PaletteEntryCount = 0;             // Palette entries already in the saved file or the journal
+        std::vector<PackedTile> m_PendingLayout;    // Palette to record before the first edit, see Start
+    };
+}
@@ -0,0 +1,524 @@
+#include "FloodFill.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "BitUtils.h"
+
+#include "Lumina/Core/Assert.h"
+
+namespace Tiles
+{
+    namespace
+    {
+        // Union-find over block edge components that any number of threads can join and search.
+        // Roots always link to the smaller id, so concurrent joins agree on a single root.
+        class ConcurrentUnionFind
+        {
+        public:
+            explicit ConcurrentUnionFind(size_t count) : m_Parents(count)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    m_Parents[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+                }
+            }
+
+            uint32_t Find(uint32_t id)
+            {
+                while (true)
+                {
+                    uint32_t parent = m_Parents[id].load(std::memory_order_acquire);
+                    if (parent == id)
+                        return id;
+
+                    // Path halving, losing the race only means the path stays a little longer
+                    uint32_t grandparent = m_Parents[parent].load(std::memory_order_acquire);
+                    if (parent != grandparent)
+                        m_Parents[id].compare_exchange_weak(parent, grandparent, std::memory_order_release, std::memory_order_relaxed);
+
+                    id = grandparent;
+                }
+            }
+
+            void Union(uint32_t a, uint32_t b)
+            {
+                while (true)
+                {
+                    a = Find(a);
+                    b = Find(b);
+                    if (a == b)
+                        return;
+
+                    if (a < b)
+                        std::swap(a, b);
+
+                    uint32_t expected = a;
+                    if (m_Parents[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel))
+                        return;
+                }
+            }
+
+        private:
+            std::vector<std::atomic<uint32_t>> m_Parents;
+        };
+
+        // Bits [start, end) of a chunk row
+        uint32_t GetSpanMask(uint32_t start, uint32_t end)
+        {
+            return (end - start < TileChunk::SIZE ? (1u << (end - start)) - 1 : ~0u) << start;
+        }
+
+        // Plain union-find over the runs of a single block
+        uint16_t FindRun(std::array<uint16_t, TileChunk::TILE_COUNT / 2>& parents, uint16_t run)
+        {
+            while (parents[run] != run)
+            {
+                parents[run] = parents[parents[run]];
+                run = parents[run];
+            }
+            return run;
+        }
+    }
+
+    FloodFill::FloodFill(const TileLayer& layer, const TileBounds& bounds, uint16_t targetTileIndex)
+        : m_Layer(layer), m_Bounds(bounds), m_TargetTileIndex(targetTileIndex)
+    {
+    }
+
+    size_t FloodFill::Run(int32_t x, int32_t y, size_t maxCount)
+    {
+        size_t filledBefore = m_FilledCount;
+
+        // One seed per span discovered next to a filled span, so the stack stays small
+        std::vector<std::pair<int32_t, int32_t>> seeds;
+        seeds.push_back({ x, y });
+
+        while (!seeds.empty() && m_FilledCount - filledBefore < maxCount)
+        {
+            auto [seedX, seedY] = seeds.back();
+            seeds.pop_back();
+
+            if (!IsAvailable(seedX, seedY))
+                continue;
+
+            int32_t left = ExtendLeft(seedX, seedY);
+            int32_t right = ExtendRight(seedX, seedY);
+            MarkVisited(left, right, seedY);
+
+            for (int32_t neighbourY : { seedY - 1, seedY + 1 })
+            {
+                if (neighbourY < m_Bounds.MinY || neighbourY >= m_Bounds.MaxY)
+                    continue;
+
+                // Push the first tile of every available run that touches [left, right)
+                int32_t spanX = left;
+                while (spanX < right)
+                {
+                    int32_t chunkX = TileChunk::GetChunkCoord(spanX);
+                    uint32_t localX = TileChunk::GetLocalCoord(spanX);
+                    uint32_t length = std::min<uint32_t>(TileChunk::SIZE - localX, static_cast<uint32_t>(right - spanX));
+
+                    uint32_t rangeMask = (length < TileChunk::SIZE ? (1u << length) - 1 : ~0u) << localX;
+                    uint32_t available = GetAvailableMask(chunkX, neighbourY) & rangeMask;
+
+                    // Run starts are available bits whose lower neighbour is not available
+                    uint32_t runStarts = available & ~(available << 1);
+                    while (runStarts != 0)
+                    {
+                        uint32_t bit = BitUtils::CountTrailingZeros(runStarts);
+                        runStarts &= runStarts - 1;
+                        seeds.push_back({ chunkX * static_cast<int32_t>(TileChunk::SIZE) + static_cast<int32_t>(bit), neighbourY });
+                    }
+
+                    spanX += static_cast<int32_t>(length);
+                }
+            }
+        }
+
+        return m_FilledCount - filledBefore;
+    }
+
+    size_t FloodFill::RunParallel(int32_t x, int32_t y, WorkerPool& pool)
+    {
+        if (!IsAvailable(x, y))
+            return 0;
+
+        int32_t firstChunkX = TileChunk::GetChunkCoord(m_Bounds.MinX);
+        int32_t firstChunkY = TileChunk::GetChunkCoord(m_Bounds.MinY);
+        size_t blocksX = static_cast<size_t>(TileChunk::GetChunkCoord(m_Bounds.MaxX - 1) - firstChunkX) + 1;
+        size_t blocksY = static_cast<size_t>(TileChunk::GetChunkCoord(m_Bounds.MaxY - 1) - firstChunkY) + 1;
+
+        // Label every block on its own. Only components touching a block edge can reach another
+        // block, so only their labels are kept.
+        std::vector<BlockLabels> blocks(blocksX * blocksY);
+        pool.ParallelFor(blocksY, [&](size_t blockY)
+            {
+                std::vector<BlockRun> runs;
+                for (size_t blockX = 0; blockX < blocksX; blockX++)
+                {
+                    BlockLabels& block = blocks[blockY * blocksX + blockX];
+                    block.Edges.fill(BlockLabels::NONE);
+
+                    uint32_t edgeCount = 0;
+                    RowMasks masks = GetBlockMasks(firstChunkX + static_cast<int32_t>(blockX), firstChunkY + static_cast<int32_t>(blockY));
+                    block.ComponentCount = static_cast<uint16_t>(LabelBlock(masks, runs, edgeCount));
+                    block.EdgeCount = static_cast<uint8_t>(edgeCount);
+
+                    for (const BlockRun& run : runs)
+                    {
+                        if (run.Component >= edgeCount)
+                            continue;
+
+                        uint8_t component = static_cast<uint8_t>(run.Component);
+                        if (run.Y == 0)
+                            std::fill(block.Edges.begin() + BlockLabels::TOP * TileChunk::SIZE + run.Start, block.Edges.begin() + BlockLabels::TOP * TileChunk::SIZE + run.End, component);
+                        if (run.Y == TileChunk::MASK)
+                            std::fill(block.Edges.begin() + BlockLabels::BOTTOM * TileChunk::SIZE + run.Start, block.Edges.begin() + BlockLabels::BOTTOM * TileChunk::SIZE + run.End, component);
+                        if (run.Start == 0)
+                            block.Edges[BlockLabels::LEFT * TileChunk::SIZE + run.Y] = component;
+                        if (run.End == TileChunk::SIZE)
+                            block.Edges[BlockLabels::RIGHT * TileChunk::SIZE + run.Y] = component;
+                    }
+                }
+            });
+
+        uint32_t edgeComponentCount = 0;
+        for (BlockLabels& block : blocks)
+        {
+            block.FirstEdgeId = edgeComponentCount;
+            edgeComponentCount += block.EdgeCount;
+        }
+
+        // Join edge components with the components on the other side of the right and bottom edges
+        ConcurrentUnionFind components(edgeComponentCount);
+        pool.ParallelFor(blocksY, [&](size_t blockY)
+            {
+                for (size_t blockX = 0; blockX < blocksX; blockX++)
+                {
+                    const BlockLabels& block = blocks[blockY * blocksX + blockX];
+                    if (block.EdgeCount == 0)
+                        continue;
+
+                    auto join = [&](const BlockLabels& neighbour, BlockLabels::Edge edge, BlockLabels::Edge neighbourEdge)
+                        {
+                            for (uint32_t i = 0; i < TileChunk::SIZE; i++)
+                            {
+                                uint8_t component = block.Edges[edge * TileChunk::SIZE + i];
+                                uint8_t neighbourComponent = neighbour.Edges[neighbourEdge * TileChunk::SIZE + i];
+                                if (component != BlockLabels::NONE && neighbourComponent != BlockLabels::NONE)
+                                    components.Union(block.FirstEdgeId + component, neighbour.FirstEdgeId + neighbourComponent);
+                            }
+                        };
+
+                    if (blockX + 1 < blocksX)
+                        join(blocks[blockY * blocksX + blockX + 1], BlockLabels::RIGHT, BlockLabels::LEFT);
+                    if (blockY + 1 < blocksY)
+                        join(blocks[(blockY + 1) * blocksX + blockX], BlockLabels::BOTTOM, BlockLabels::TOP);
+                }
+            });
+
+        // Find the component of the seed, blocks are labelled the same way every time
+        int32_t seedChunkX = TileChunk::GetChunkCoord(x);
+        int32_t seedChunkY = TileChunk::GetChunkCoord(y);
+        size_t seedBlock = static_cast<size_t>(seedChunkY - firstChunkY) * blocksX + static_cast<size_t>(seedChunkX - firstChunkX);
+        uint32_t seedLocalX = TileChunk::GetLocalCoord(x);
+        uint32_t seedLocalY = TileChunk::GetLocalCoord(y);
+
+        std::vector<BlockRun> seedRuns;
+        uint32_t seedEdgeCount = 0;
+        LabelBlock(GetBlockMasks(seedChunkX, seedChunkY), seedRuns, seedEdgeCount);
+
+        auto seedRun = std::find_if(seedRuns.begin(), seedRuns.end(), [&](const BlockRun& run)
+            {
+                return run.Y == seedLocalY && run.Start <= seedLocalX && seedLocalX < run.End;
+            });
+        LUMINA_ASSERT(seedRun != seedRuns.end(), "FloodFill::RunParallel: Seed tile is not part of any run");
+
+        // A component that never touches its block edge is the whole region
+        std::vector<std::vector<std::pair<uint64_t, RowMasks>>> filled(blocksY);
+        if (seedRun->Component >= seedEdgeCount)
+        {
+            RowMasks masks = {};
+            for (const BlockRun& run : seedRuns)
+            {
+                if (run.Component == seedRun->Component)
+                    masks[run.Y] |= GetSpanMask(run.Start, run.End);
+            }
+            filled[0].push_back({ TileLayer::GetChunkKey(seedChunkX, seedChunkY), masks });
+        }
+        else
+        {
+            uint32_t seedRoot = components.Find(blocks[seedBlock].FirstEdgeId + seedRun->Component);
+
+            pool.ParallelFor(blocksY, [&](size_t blockY)
+                {
+                    std::vector<BlockRun> runs;
+                    for (size_t blockX = 0; blockX < blocksX; blockX++)
+                    {
+                        const BlockLabels& block = blocks[blockY * blocksX + blockX];
+
+                        std::array<bool, 4 * TileChunk::SIZE> selected = {};
+                        bool anySelected = false;
+                        for (uint32_t component = 0; component < block.EdgeCount; component++)
+                        {
+                            selected[component] = components.Find(block.FirstEdgeId + component) == seedRoot;
+                            anySelected |= selected[component];
+                        }
+                        if (!anySelected)
+                            continue;
+
+                        int32_t chunkX = firstChunkX + static_cast<int32_t>(blockX);
+                        int32_t chunkY = firstChunkY + static_cast<int32_t>(blockY);
+                        RowMasks masks = GetBlockMasks(chunkX, chunkY);
+
+                        // Blocks made of a single component are filled as they are
+                        if (block.ComponentCount > 1)
+                        {
+                            uint32_t edgeCount = 0;
+                            LabelBlock(masks, runs, edgeCount);
+
+                            masks.fill(0);
+                            for (const BlockRun& run : runs)
+                            {
+                                if (run.Component < edgeCount && selected[run.Component])
+                                    masks[run.Y] |= GetSpanMask(run.Start, run.End);
+                            }
+                        }
+
+                        filled[blockY].push_back({ TileLayer::GetChunkKey(chunkX, chunkY), masks });
+                    }
+                });
+        }
+
+        size_t filledBefore = m_FilledCount;
+        for (const auto& blockRow : filled)
+        {
+            for (const auto& [chunkKey, masks] : blockRow)
+            {
+                RowMasks& visited = m_Visited[chunkKey];
+                for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+                {
+                    visited[localY] |= masks[localY];
+                    m_FilledCount += BitUtils::PopCount(masks[localY]);
+                }
+            }
+        }
+
+        return m_FilledCount - filledBefore;
+    }
+
+    void FloodFill::Apply(TileLayer& layer, uint16_t fillTileIndex) const
+    {
+        for (const auto& [chunkKey, rowMasks] : m_Visited)
+        {
+            layer.FillChunkMasked(TileLayer::GetChunkX(chunkKey), TileLayer::GetChunkY(chunkKey), rowMasks, fillTileIndex);
+        }
+    }
+
+    TileDelta FloodFill::GetDelta() const
+    {
+        TileDelta delta;
+        for (const auto& [chunkKey, rowMasks] : m_Visited)
+        {
+            delta.AddChunk(TileLayer::GetChunkX(chunkKey), TileLayer::GetChunkY(chunkKey), rowMasks, m_TargetTileIndex);
+        }
+        return delta;
+    }
+
+    uint32_t FloodFill::GetAvailableMask(int32_t chunkX, int32_t y) const
+    {
+        uint32_t boundsMask = GetBoundsMask(chunkX);
+        if (boundsMask == 0)
+            return 0;
+
+        int32_t chunkY = TileChunk::GetChunkCoord(y);
+        uint32_t localY = TileChunk::GetLocalCoord(y);
+        uint32_t matchMask = GetMatchMask(m_Layer.GetChunk(chunkX, chunkY), localY);
+
+        auto visited = m_Visited.find(TileLayer::GetChunkKey(chunkX, chunkY));
+        uint32_t visitedMask = visited != m_Visited.end() ? visited->second[localY] : 0;
+
+        return matchMask & boundsMask & ~visitedMask;
+    }
+
+    FloodFill::RowMasks FloodFill::GetBlockMasks(int32_t chunkX, int32_t chunkY) const
+    {
+        RowMasks masks = {};
+        uint32_t boundsMask = GetBoundsMask(chunkX);
+        if (boundsMask == 0)
+            return masks;
+
+        const TileChunk* chunk = m_Layer.GetChunk(chunkX, chunkY);
+        auto visited = m_Visited.find(TileLayer::GetChunkKey(chunkX, chunkY));
+
+        int32_t originY = chunkY * static_cast<int32_t>(TileChunk::SIZE);
+        for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+        {
+            int32_t y = originY + static_cast<int32_t>(localY);
+            if (y < m_Bounds.MinY || y >= m_Bounds.MaxY)
+                continue;
+
+            uint32_t visitedMask = visited != m_Visited.end() ? visited->second[localY] : 0;
+            masks[localY] = GetMatchMask(chunk, localY) & boundsMask & ~visitedMask;
+        }
+        return masks;
+    }
+
+    uint32_t FloodFill::LabelBlock(const RowMasks& masks, std::vector<BlockRun>& runs, uint32_t& edgeCount)
+    {
+        // At most every other tile starts a run
+        std::array<uint16_t, TileChunk::TILE_COUNT / 2> parents;
+
+        // Cut every row into runs and join each run with the runs it touches in the row above
+        runs.clear();
+        size_t previousBegin = 0;
+        for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+        {
+            size_t rowBegin = runs.size();
+            size_t previous = previousBegin;
+
+            uint32_t mask = masks[localY];
+            while (mask != 0)
+            {
+                uint32_t start = BitUtils::CountTrailingZeros(mask);
+                uint32_t shifted = ~(mask >> start);
+                uint32_t end = shifted == 0 ? TileChunk::SIZE : start + BitUtils::CountTrailingZeros(shifted);
+                mask &= end < TileChunk::SIZE ? ~0u << end : 0;
+
+                uint16_t id = static_cast<uint16_t>(runs.size());
+                parents[id] = id;
+                runs.push_back({ static_cast<uint8_t>(localY), static_cast<uint8_t>(start), static_cast<uint8_t>(end), id });
+
+                // Runs of a row are sorted, so runs above that end before this one never touch later runs either
+                while (previous < rowBegin && runs[previous].End <= start)
+                    previous++;
+
+                for (size_t above = previous; above < rowBegin && runs[above].Start < end; above++)
+                {
+                    uint16_t a = FindRun(parents, static_cast<uint16_t>(above));
+                    uint16_t b = FindRun(parents, id);
+                    parents[std::max(a, b)] = std::min(a, b);
+                }
+            }
+
+            previousBegin = rowBegin;
+        }
+
+        // Number the components, the ones touching the block edge first
+        constexpr uint16_t UNNUMBERED = 0xFFFF;
+        std::array<uint16_t, TileChunk::TILE_COUNT / 2> numbers;
+        std::fill_n(numbers.begin(), runs.size(), UNNUMBERED);
+
+        uint32_t count = 0;
+        for (const BlockRun& run : runs)
+        {
+            bool onEdge = run.Y == 0 || run.Y == TileChunk::MASK || run.Start == 0 || run.End == TileChunk::SIZE;
+            uint16_t root = FindRun(parents, run.Component);
+            if (onEdge && numbers[root] == UNNUMBERED)
+                numbers[root] = static_cast<uint16_t>(count++);
+        }
+        edgeCount = count;
+
+        for (BlockRun& run : runs)
+        {
+            uint16_t root = FindRun(parents, run.Component);
+            if (numbers[root] == UNNUMBERED)
+                numbers[root] = static_cast<uint16_t>(count++);
+            run.Component = numbers[root];
+        }
+
+        return count;
+    }
+
+    uint32_t FloodFill::GetMatchMask(const TileChunk* chunk, uint32_t localY) const
+    {
+        // Missing chunks hold only default tiles, and a chunk row mask already says which tiles are default
+        if (!chunk)
+            return m_TargetTileIndex == TilePalette::DEFAULT_INDEX ? ~0u : 0;
+
+        if (m_TargetTileIndex == TilePalette::DEFAULT_INDEX)
+            return ~chunk->GetRowMask(localY);
+
+        uint32_t matchMask = 0;
+        const uint16_t* row = chunk->GetRow(localY);
+        for (uint32_t localX = 0; localX < TileChunk::SIZE; localX++)
+        {
+            matchMask |= static_cast<uint32_t>(row[localX] == m_TargetTileIndex) << localX;
+        }
+        return matchMask;
+    }
+
+    uint32_t FloodFill::GetBoundsMask(int32_t chunkX) const
+    {
+        int64_t originX = static_cast<int64_t>(chunkX) * TileChunk::SIZE;
+        int64_t first = std::clamp<int64_t>(m_Bounds.MinX - originX, 0, TileChunk::SIZE);
+        int64_t last = std::clamp<int64_t>(m_Bounds.MaxX - originX, 0, TileChunk::SIZE);
+        if (first >= last)
+            return 0;
+
+        return GetSpanMask(static_cast<uint32_t>(first), static_cast<uint32_t>(last));
+    }
+
+    bool FloodFill::IsAvailable(int32_t x, int32_t y) const
+    {
+        if (!m_Bounds.Contains(x, y))
+            return false;
+
+        return (GetAvailableMask(TileChunk::GetChunkCoord(x), y) >> TileChunk::GetLocalCoord(x)) & 1u;
+    }
+
+    int32_t FloodFill::ExtendLeft(int32_t x, int32_t y) const
+    {
+        int32_t current = x;
+        while (true)
+        {
+            uint32_t localX = TileChunk::GetLocalCoord(current);
+
+            // Bit 31 is the current tile, count available tiles going down from it
+            uint32_t shifted = ~(GetAvailableMask(TileChunk::GetChunkCoord(current), y) << (TileChunk::MASK - localX));
+            uint32_t run = shifted == 0 ? TileChunk::SIZE : TileChunk::MASK - BitUtils::FindLastSet(shifted);
+
+            current -= static_cast<int32_t>(run);
+            if (run < localX + 1)
+                return current + 1;
+        }
+    }
+
+    int32_t FloodFill::ExtendRight(int32_t x, int32_t y) const
+    {
+        int32_t current = x;
+        while (true)
+        {
+            uint32_t localX = TileChunk::GetLocalCoord(current);
+
+            // Bit 0 is the current tile, count available tiles going up from it
+            uint32_t shifted = ~(GetAvailableMask(TileChunk::GetChunkCoord(current), y) >> localX);
+            uint32_t run = shifted == 0 ? TileChunk::SIZE : BitUtils::CountTrailingZeros(shifted);
+
+            current += static_cast<int32_t>(run);
+            if (run < TileChunk::SIZE - localX)
+                return current;
+        }
+    }
+
+    void FloodFill::MarkVisited(int32_t left, int32_t right, int32_t y)
+    {
+        int32_t chunkY = TileChunk::GetChunkCoord(y);
+        uint32_t localY = TileChunk::GetLocalCoord(y);
+
+        int32_t x = left;
+        while (x < right)
+        {
+            int32_t chunkX = TileChunk::GetChunkCoord(x);
+            uint32_t localX = TileChunk::GetLocalCoord(x);
+            uint32_t length = std::min<uint32_t>(TileChunk::SIZE - localX, static_cast<uint32_t>(right - x));
+
+            m_Visited[TileLayer::GetChunkKey(chunkX, chunkY)][localY] |= (length < TileChunk::SIZE ? (1u << length) - 1 : ~0u) << localX;
+            x += static_cast<int32_t>(length);
+        }
+
+        m_FilledCount += static_cast<size_t>(right - left);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "TileChunk.h"
+#include "TileDelta.h"
+#include "TileLayer.h"
+#include "WorkerPool.h"
+
+namespace Tiles
+{
+    // Scanline flood fill over a TileLayer. Each 32 tile chunk row is turned into a bitmask of the
+    // tiles matching the target palette index, so growing a span is a couple of bit scans instead of
+    // a compare per tile. Visited tiles live in a sparse per-chunk bitmap, so memory grows with the
+    // filled area rather than with the fill bounds.
+    //
+    // RunParallel marks the same region by labelling every chunk-sized block of the bounds on its
+    // own and joining the labels across block edges with a union-find, see RunParallel.
+    class FloodFill
+    {
+    public:
+        // Regions of at least this many tiles are worth labelling on every core
+        static constexpr size_t PARALLEL_TILE_COUNT = 1 << 20;
+
+        FloodFill(const TileLayer& layer, const TileBounds& bounds, uint16_t targetTileIndex);
+        ~FloodFill() = default;
+
+        // Marks the 4-connected region of target tiles containing (x, y), returns the number of tiles added.
+        // Stops once maxCount tiles were added, the marked tiles are then only part of the region.
+        size_t Run(int32_t x, int32_t y, size_t maxCount = SIZE_MAX);
+
+        // Same result as Run, but labels the whole bounds block by block on the pool. The cost grows
+        // with the bounds rather than with the filled area, so it only pays off for large fills.
+        size_t RunParallel(int32_t x, int32_t y, WorkerPool& pool = WorkerPool::Get());
+
+        // Writes fillTileIndex over every marked tile, one chunk at a time
+        void Apply(TileLayer& layer, uint16_t fillTileIndex) const;
+
+        // Marked tiles with the target index they held, for undoing Apply
+        TileDelta GetDelta() const;
+
+        size_t GetFilledCount() const { return m_FilledCount; }
+
+    private:
+        using RowMasks = std::array<uint32_t, TileChunk::SIZE>;
+
+        // Horizontal run of available tiles within a block
+        struct BlockRun
+        {
+            uint8_t Y;                                          // Local row
+            uint8_t Start;                                      // First local column
+            uint8_t End;                                        // One past the last local column
+            uint16_t Component;                                 // Block component, edge components first
+        };
+
+        // Connectivity of one block as seen from its neighbours
+        struct BlockLabels
+        {
+            static constexpr uint8_t NONE = 0xFF;
+            enum Edge { TOP = 0, BOTTOM, LEFT, RIGHT };
+
+            uint32_t FirstEdgeId = 0;                           // Union-find id of edge component 0
+            uint16_t ComponentCount = 0;                        // Components in the block
+            uint8_t EdgeCount = 0;                              // Components touching the block edge
+            std::array<uint8_t, 4 * TileChunk::SIZE> Edges;     // Edge component of each edge tile, or NONE
+        };
+
+        // Tiles of every row of a block that are available, see GetAvailableMask
+        RowMasks GetBlockMasks(int32_t chunkX, int32_t chunkY) const;
+
+        // Splits a block into 4-connected components and returns the component count. Components that
+        // touch the block edge are numbered first, edgeCount receives how many there are.
+        static uint32_t LabelBlock(const RowMasks& masks, std::vector<BlockRun>& runs, uint32_t& edgeCount);
+
+        uint32_t GetMatchMask(const TileChunk* chunk, uint32_t localY) const;
+        uint32_t GetBoundsMask(int32_t chunkX) const;
+
+        // Tiles of a chunk row that match the target, are inside the bounds and were not visited yet
+        uint32_t GetAvailableMask(int32_t chunkX, int32_t y) const;
+        bool IsAvailable(int32_t x, int32_t y) const;
+
+        // First available tile of the span through (x, y), and one past its last
+        int32_t ExtendLeft(int32_t x, int32_t y) const;
+        int32_t ExtendRight(int32_t x, int32_t y) const;
+
+        void MarkVisited(int32_t left, int32_t right, int32_t y);
+
+    private:
+        const TileLayer& m_Layer;                               // Layer being scanned, only read
+        TileBounds m_Bounds;                                    // Tiles outside are never filled
+        uint16_t m_TargetTileIndex;                             // Palette index the fill replaces
+        std::unordered_map<uint64_t, RowMasks> m_Visited;       // Visited bitmap, keyed by TileLayer::GetChunkKey
+        size_t m_FilledCount = 0;                               // Number of tiles marked so far
+    };
+}
@@ -0,0 +1,219 @@
+#include "JsonWriter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+#include "Lumina/Core/Assert.h"
+
+namespace Tiles
+{
+    JsonWriter::JsonWriter(std::ostream& stream, bool pretty)
+        : m_Stream(stream), m_Pretty(pretty), m_Buffer(BUFFER_SIZE)
+    {
+    }
+
+    void JsonWriter::BeginObject()
+    {
+        BeginValue();
+        Append('{');
+        m_Scopes.push_back({ true, true });
+    }
+
+    void JsonWriter::EndObject()
+    {
+        LUMINA_ASSERT(!m_Scopes.empty() && m_Scopes.back().IsObject, "JsonWriter::EndObject: No open object");
+        EndContainer('}');
+    }
+
+    void JsonWriter::BeginArray()
+    {
+        BeginValue();
+        Append('[');
+        m_Scopes.push_back({ false, true });
+    }
+
+    void JsonWriter::EndArray()
+    {
+        LUMINA_ASSERT(!m_Scopes.empty() && !m_Scopes.back().IsObject, "JsonWriter::EndArray: No open array");
+        EndContainer(']');
+    }
+
+    void JsonWriter::Key(std::string_view key)
+    {
+        LUMINA_ASSERT(!m_Scopes.empty() && m_Scopes.back().IsObject && !m_AfterKey, "JsonWriter::Key: Keys only go directly inside objects");
+
+        BeginValue();
+        WriteString(key);
+        Append(':');
+        if (m_Pretty)
+            Append(' ');
+        m_AfterKey = true;
+    }
+
+    void JsonWriter::Null()
+    {
+        BeginValue();
+        Append("null", 4);
+    }
+
+    void JsonWriter::Bool(bool value)
+    {
+        BeginValue();
+        if (value)
+            Append("true", 4);
+        else
+            Append("false", 5);
+    }
+
+    void JsonWriter::Int(int64_t value)
+    {
+        BeginValue();
+        char text[24];
+        std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+        Append(text, result.ptr - text);
+    }
+
+    void JsonWriter::UInt(uint64_t value)
+    {
+        BeginValue();
+        char text[24];
+        std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+        Append(text, result.ptr - text);
+    }
+
+    void JsonWriter::Float(float value)
+    {
+        // JSON has no representation for infinity or NaN, nlohmann writes those as null as well
+        if (!std::isfinite(value))
+        {
+            Null();
+            return;
+        }
+
+        BeginValue();
+        char text[32];
+        std::to_chars_result result = std::to_chars(text, text + sizeof(text) - 2, value);
+        size_t length = result.ptr - text;
+
+        // Keep whole numbers recognizable as floats, 1.0 rather than 1
+        if (std::string_view(text, length).find_first_of(".e") == std::string_view::npos)
+        {
+            text[length++] = '.';
+            text[length++] = '0';
+        }
+        Append(text, length);
+    }
+
+    void JsonWriter::String(std::string_view value)
+    {
+        BeginValue();
+        WriteString(value);
+    }
+
+    void JsonWriter::Flush()
+    {
+        if (m_Size == 0)
+            return;
+
+        m_Stream.write(m_Buffer.data(), static_cast<std::streamsize>(m_Size));
+        m_Size = 0;
+    }
+
+    void JsonWriter::WriteString(std::string_view value)
+    {
+        static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+        Append('"');
+
+        // Runs of characters that need no escaping are copied in one go
+        size_t runStart = 0;
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            unsigned char c = static_cast<unsigned char>(value[i]);
+            if (c >= 0x20 && c != '"' && c != '\\')
+                continue;
+
+            Append(value.data() + runStart, i - runStart);
+            runStart = i + 1;
+
+            switch (c)
+            {
+            case '"': Append("\\\"", 2); break;
+            case '\\': Append("\\\\", 2); break;
+            case '\b': Append("\\b", 2); break;
+            case '\f': Append("\\f", 2); break;
+            case '\n': Append("\\n", 2); break;
+            case '\r': Append("\\r", 2); break;
+            case '\t': Append("\\t", 2); break;
+            default:
+            {
+                char escape[6] = { '\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0xF] };
+                Append(escape, sizeof(escape));
+                break;
+            }
+            }
+        }
+        Append(value.data() + runStart, value.size() - runStart);
+
+        Append('"');
+    }
+
+    void JsonWriter::BeginValue()
+    {
+        if (m_AfterKey)
+        {
+            m_AfterKey = false;
+            return;
+        }
+
+        if (m_Scopes.empty())
+            return;
+
+        Scope& scope = m_Scopes.back();
+        if (!scope.IsEmpty)
+            Append(',');
+        scope.IsEmpty = false;
+        NewLine();
+    }
+
+    void JsonWriter::EndContainer(char close)
+    {
+        LUMINA_ASSERT(!m_AfterKey, "JsonWriter: Key without a value");
+
+        bool isEmpty = m_Scopes.back().IsEmpty;
+        m_Scopes.pop_back();
+
+        // Empty containers stay on one line, [] and {}
+        if (!isEmpty)
+            NewLine();
+        Append(close);
+    }
+
+    void JsonWriter::NewLine()
+    {
+        if (!m_Pretty)
+            return;
+
+        Append('\n');
+        for (size_t i = 0; i < m_Scopes.size() * INDENT; i++)
+        {
+            Append(' ');
+        }
+    }
+
+    void JsonWriter::Append(const char* text, size_t length)
+    {
+        while (length > 0)
+        {
+            if (m_Size == BUFFER_SIZE)
+                Flush();
+
+            size_t count = std::min(length, BUFFER_SIZE - m_Size);
+            std::copy(text, text + count, m_Buffer.data() + m_Size);
+            m_Size += count;
+            text += count;
+            length -= count;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace Tiles
+{
+    // Streams JSON text straight to an output stream through a fixed-size buffer, so writing a
+    // document takes constant memory however large it is. Values are written in call order:
+    //
+    //   writer.BeginObject();
+    //   writer.Key("name"); writer.String("Layer");
+    //   writer.Key("size"); writer.BeginArray(); writer.UInt(32); writer.UInt(32); writer.EndArray();
+    //   writer.EndObject();
+    //
+    // Pretty output indents like nlohmann::json::dump(4), compact output has no whitespace at all.
+    class JsonWriter
+    {
+    public:
+        JsonWriter(std::ostream& stream, bool pretty = false);
+        ~JsonWriter() { Flush(); }
+
+        JsonWriter(const JsonWriter&) = delete;
+        JsonWriter& operator=(const JsonWriter&) = delete;
+
+        void BeginObject();
+        void EndObject();
+        void BeginArray();
+        void EndArray();
+
+        // Inside objects every value is preceded by its key
+        void Key(std::string_view key);
+
+        void Null();
+        void Bool(bool value);
+        void Int(int64_t value);
+        void UInt(uint64_t value);
+        void Float(float value);                    // Shortest text that reads back to the same float, null when not finite
+        void String(std::string_view value);
+
+        // Hands the buffered text to the stream, the caller checks the stream for errors
+        void Flush();
+
+    private:
+        // Separator and indentation before a value or key
+        void BeginValue();
+        void EndContainer(char close);
+        void NewLine();
+        void WriteString(std::string_view value);   // Quoted and escaped, without a separator
+
+        void Append(char c)
+        {
+            if (m_Size == BUFFER_SIZE)
+                Flush();
+            m_Buffer[m_Size++] = c;
+        }
+        void Append(const char* text, size_t length);
+
+        struct Scope
+        {
+            bool IsObject = false;
+            bool IsEmpty = true;
+        };
+
+        std::ostream& m_Stream;
+        bool m_Pretty = false;
+        bool m_AfterKey = false;                    // The next value belongs to the key just written
+
+        std::vector<Scope> m_Scopes;                // Open containers, innermost last
+        std::vector<char> m_Buffer;
+        size_t m_Size = 0;                          // Bytes of m_Buffer not yet flushed
+
+        static constexpr size_t BUFFER_SIZE = 64 * 1024;
+        static constexpr int INDENT = 4;
+    };
+}
@@ -0,0 +1,193 @@
+#include "LZ.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Tiles
+{
+    namespace LZ
+    {
+        namespace
+        {
+            constexpr uint32_t HASH_BITS = 10;
+            constexpr uint8_t NIBBLE_MAX = 15;
+
+            uint32_t Read32(const uint8_t* data)
+            {
+                uint32_t value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+            }
+
+            uint32_t Hash(uint32_t value)
+            {
+                return (value * 2654435761u) >> (32 - HASH_BITS);
+            }
+
+            // Writes the bytes that extend a length past its nibble, false when out of space
+            bool WriteLength(size_t length, uint8_t*& output, const uint8_t* outputEnd)
+            {
+                for (; length >= 255; length -= 255)
+                {
+                    if (output == outputEnd)
+                        return false;
+                    *output++ = 255;
+                }
+
+                if (output == outputEnd)
+                    return false;
+                *output++ = static_cast<uint8_t>(length);
+                return true;
+            }
+
+            // Adds the extension bytes of a length to its nibble value, false on truncated input
+            bool ReadLength(size_t& length, const uint8_t*& input, const uint8_t* inputEnd, size_t limit)
+            {
+                uint8_t extension;
+                do
+                {
+                    if (input == inputEnd || length > limit)
+                        return false;
+                    extension = *input++;
+                    length += extension;
+                } while (extension == 255);
+
+                return true;
+            }
+
+            // One sequence, matchLength is 0 for the last one which has no match
+            bool WriteSequence(const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength, uint8_t*& output, const uint8_t* outputEnd)
+            {
+                size_t matchCode = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+
+                if (output == outputEnd)
+                    return false;
+                uint8_t* token = output++;
+                *token = static_cast<uint8_t>((std::min<size_t>(literalLength, NIBBLE_MAX) << 4) | std::min<size_t>(matchCode, NIBBLE_MAX));
+
+                if (literalLength >= NIBBLE_MAX && !WriteLength(literalLength - NIBBLE_MAX, output, outputEnd))
+                    return false;
+
+                if (literalLength > static_cast<size_t>(outputEnd - output))
+                    return false;
+                if (literalLength > 0)
+                    std::memcpy(output, literals, literalLength);
+                output += literalLength;
+
+                if (matchLength == 0)
+                    return true;
+
+                if (outputEnd - output < 2)
+                    return false;
+                *output++ = static_cast<uint8_t>(offset);
+                *output++ = static_cast<uint8_t>(offset >> 8);
+
+                return matchCode < NIBBLE_MAX || WriteLength(matchCode - NIBBLE_MAX, output, outputEnd);
+            }
+        }
+
+        size_t Compress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationCapacity)
+        {
+            // Positions are stored plus one so zero means empty
+            std::array<uint32_t, 1 << HASH_BITS> table = {};
+
+            uint8_t* output = destination;
+            const uint8_t* outputEnd = destination + destinationCapacity;
+
+            size_t anchor = 0;
+            size_t position = 0;
+            while (position + MIN_MATCH <= sourceSize)
+            {
+                uint32_t value = Read32(source + position);
+                uint32_t& entry = table[Hash(value)];
+                size_t candidate = entry;
+                entry = static_cast<uint32_t>(position + 1);
+
+                if (candidate == 0 || position + 1 - candidate > MAX_OFFSET || Read32(source + candidate - 1) != value)
+                {
+                    position++;
+                    continue;
+                }
+                candidate--;
+
+                size_t matchLength = MIN_MATCH;
+                while (position + matchLength < sourceSize && source[candidate + matchLength] == source[position + matchLength])
+                {
+                    matchLength++;
+                }
+
+                if (!WriteSequence(source + anchor, position - anchor, position - candidate, matchLength, output, outputEnd))
+                    return 0;
+
+                position += matchLength;
+                anchor = position;
+            }
+
+            if (!WriteSequence(source + anchor, sourceSize - anchor, 0, 0, output, outputEnd))
+                return 0;
+
+            return static_cast<size_t>(output - destination);
+        }
+
+        size_t Decompress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationCapacity)
+        {
+            const uint8_t* input = source;
+            const uint8_t* inputEnd = source + sourceSize;
+            size_t outputSize = 0;
+
+            while (input != inputEnd)
+            {
+                uint8_t token = *input++;
+
+                size_t literalLength = token >> 4;
+                if (literalLength == NIBBLE_MAX && !ReadLength(literalLength, input, inputEnd, destinationCapacity))
+                    return SIZE_MAX;
+
+                if (literalLength > static_cast<size_t>(inputEnd - input) || literalLength > destinationCapacity - outputSize)
+                    return SIZE_MAX;
+                if (literalLength > 0)
+                    std::memcpy(destination + outputSize, input, literalLength);
+                input += literalLength;
+                outputSize += literalLength;
+
+                // The last sequence ends with its literals
+                if (input == inputEnd)
+                    break;
+
+                if (inputEnd - input < 2)
+                    return SIZE_MAX;
+                size_t offset = input[0] | (static_cast<size_t>(input[1]) << 8);
+                input += 2;
+                if (offset == 0 || offset > outputSize)
+                    return SIZE_MAX;
+
+                size_t matchLength = token & NIBBLE_MAX;
+                if (matchLength == NIBBLE_MAX && !ReadLength(matchLength, input, inputEnd, destinationCapacity))
+                    return SIZE_MAX;
+                matchLength += MIN_MATCH;
+
+                if (matchLength > destinationCapacity - outputSize)
+                    return SIZE_MAX;
+
+                // Matches closer than their length repeat the bytes they are copying
+                uint8_t* output = destination + outputSize;
+                const uint8_t* match = output - offset;
+                if (offset >= matchLength)
+                {
+                    std::memcpy(output, match, matchLength);
+                }
+                else
+                {
+                    for (size_t i = 0; i < matchLength; i++)
+                    {
+                        output[i] = match[i];
+                    }
+                }
+                outputSize += matchLength;
+            }
+
+            return outputSize;
+        }
+    }
+}
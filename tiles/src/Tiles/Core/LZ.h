@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tiles
+{
+    // Small LZ77 block codec in the style of LZ4, made for blocks of a few kilobytes such as
+    // saved chunks. A block is a series of sequences:
+    //
+    //   token        High nibble literal length, low nibble match length - MIN_MATCH. A nibble
+    //                of 15 is followed by bytes that are added to it, until one is below 255.
+    //   literals     Copied as is
+    //   offset       Little endian uint16_t distance back to the match, left out by the last sequence
+    //
+    // Compression is a single greedy pass with a small hash table, decompression is a copy loop
+    // that checks every length and offset, so corrupt input never reads or writes out of bounds.
+    namespace LZ
+    {
+        static constexpr size_t MIN_MATCH = 4;
+        static constexpr size_t MAX_OFFSET = UINT16_MAX;
+
+        // Output size that Compress never exceeds
+        constexpr size_t GetMaxCompressedSize(size_t size) { return size + size / 255 + 16; }
+
+        // Returns the compressed size, or 0 when the output would not fit in destinationCapacity
+        size_t Compress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationCapacity);
+
+        // Returns the decompressed size, or SIZE_MAX when the input is malformed or would not fit
+        size_t Decompress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t destinationCapacity);
+    }
+}
@@ -2,12 +2,16 @@
 #include "Lumina/Core/Assert.h"
 #include "Lumina/Core/Log.h"
 #include "Constants.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
 
 namespace Tiles
 {
-    LayerStack::LayerStack(uint32_t width, uint32_t height) : m_Width(width), m_Height(height)
+    LayerStack::LayerStack(uint32_t width, uint32_t height, bool unbounded)
+        : m_Width(width), m_Height(height), m_Unbounded(unbounded), m_Palette(CreateRef<TilePalette>())
     {
-        if (width == 0 || height == 0)
+        if (!unbounded && (width == 0 || height == 0))
         {
             LUMINA_LOG_INFO("LayerStack::LayerStack: Warning - LayerStack created with zero dimensions ({}x{})", width, height);
         }
@@ -15,9 +19,10 @@ namespace Tiles
 
     void LayerStack::AddLayer(const std::string& name)
     {
-        m_Layers.emplace_back(m_Width, m_Height);
+        m_Layers.push_back(CreateLayer());
         std::string layerName = name.empty() ? "New Layer" : name;
         m_Layers.back().SetName(layerName);
+        TouchStructure();
 
         LUMINA_LOG_INFO("LayerStack::AddLayer: Added layer '{}' (total layers: {})", layerName, m_Layers.size());
     }
@@ -32,6 +37,7 @@ namespace Tiles
 
         std::string layerName = m_Layers[index].GetName();
         m_Layers.erase(m_Layers.begin() + index);
+        TouchStructure();
         LUMINA_LOG_INFO("LayerStack::RemoveLayer: Removed layer '{}' (remaining: {})", layerName, m_Layers.size());
     }
 
@@ -55,8 +61,9 @@ namespace Tiles
         }
 
         std::string layerName = name.empty() ? "New Layer" : name;
-        auto it = m_Layers.insert(m_Layers.begin() + index, TileLayer(m_Width, m_Height));
+        auto it = m_Layers.insert(m_Layers.begin() + index, CreateLayer());
         it->SetName(layerName);
+        TouchStructure();
 
         LUMINA_LOG_INFO("LayerStack::InsertLayer: Inserted layer '{}' at index {} (total: {})", layerName, index, m_Layers.size());
     }
@@ -69,14 +76,26 @@ namespace Tiles
             return;
         }
 
+        // Chunks are shared copy-on-write, so the copy is cheap and a full palette leaves the stack as it was
+        TileLayer replacement = layer;
+        replacement.Invalidate();
+        if (!replacement.SetPalette(m_Palette))
+        {
+            LUMINA_LOG_INFO("LayerStack::ReplaceLayer: Layer at index {} not replaced, its tiles do not fit the palette", index);
+            return;
+        }
+
         LUMINA_LOG_INFO("LayerStack::ReplaceLayer: Replacing layer at index {}", index);
-        m_Layers[index] = layer;
+        m_Layers[index] = std::move(replacement);
+        m_Layers[index].SetUnbounded(m_Unbounded);
 
-        if (layer.GetWidth() != m_Width || layer.GetHeight() != m_Height)
+        if (!m_Unbounded && (layer.GetWidth() != m_Width || layer.GetHeight() != m_Height))
         {
             LUMINA_LOG_INFO("LayerStack::ReplaceLayer: Resizing replaced layer from {}x{} to {}x{}", layer.GetWidth(), layer.GetHeight(), m_Width, m_Height);
             m_Layers[index].Resize(m_Width, m_Height);
         }
+
+        TouchStructure();
     }
 
     void LayerStack::SwapLayers(size_t indexA, size_t indexB)
@@ -101,12 +120,14 @@ namespace Tiles
 
         LUMINA_LOG_INFO("LayerStack::SwapLayers: Swapping layers at indices {} and {}", indexA, indexB);
         std::swap(m_Layers[indexA], m_Layers[indexB]);
+        TouchStructure();
     }
 
     void LayerStack::ClearAllLayers()
     {
         size_t layerCount = m_Layers.size();
         m_Layers.clear();
+        TouchStructure();
 
         if (layerCount > 0)
         {
@@ -130,6 +151,7 @@ namespace Tiles
 
         LUMINA_LOG_INFO("LayerStack::MoveLayerUp: Moving layer from index {} to {}", index, index - 1);
         std::swap(m_Layers[index], m_Layers[index - 1]);
+        TouchStructure();
     }
 
     void LayerStack::MoveLayerDown(size_t index)
@@ -148,10 +170,17 @@ namespace Tiles
 
         LUMINA_LOG_INFO("LayerStack::MoveLayerDown: Moving layer from index {} to {}", index, index + 1);
         std::swap(m_Layers[index], m_Layers[index + 1]);
+        TouchStructure();
     }
 
     void LayerStack::Resize(uint32_t width, uint32_t height)
     {
+        if (m_Unbounded)
+        {
+            LUMINA_LOG_INFO("LayerStack::Resize: LayerStack is unbounded, ignoring resize to {}x{}", width, height);
+            return;
+        }
+
         if (width == 0 || height == 0)
         {
             LUMINA_LOG_INFO("LayerStack::Resize: Warning - Resizing LayerStack to zero dimensions ({}x{})", width, height);
@@ -161,13 +190,94 @@ namespace Tiles
 
         m_Width = width;
         m_Height = height;
+        TouchStructure();
+
+        // Layers own their chunk tables and resizing never touches the palette, so layers resize independently
+        WorkerPool::Get().ParallelFor(m_Layers.size(), [&](size_t i)
+            {
+                m_Layers[i].Resize(width, height);
+            });
+
+        LUMINA_LOG_INFO("LayerStack::Resize: LayerStack resize completed");
+    }
+
+    TileBounds LayerStack::GetBounds() const
+    {
+        if (!m_Unbounded)
+            return { 0, 0, static_cast<int32_t>(m_Width), static_cast<int32_t>(m_Height) };
 
-        for (size_t i = 0; i < m_Layers.size(); ++i)
+        TileBounds bounds;
+        for (const auto& layer : m_Layers)
         {
-            m_Layers[i].Resize(width, height);
+            bounds = bounds.Union(layer.GetPaintedBounds());
         }
+        return bounds;
+    }
 
-        LUMINA_LOG_INFO("LayerStack::Resize: LayerStack resize completed");
+    bool LayerStack::SetPalette(const Ref<TilePalette>& palette)
+    {
+        // Layer copies share their chunks, so moving copies costs nothing until one fails
+        std::vector<TileLayer> layers = m_Layers;
+        for (TileLayer& layer : layers)
+        {
+            if (!layer.SetPalette(palette))
+                return false;
+        }
+
+        m_Layers = std::move(layers);
+        m_Palette = palette;
+        TouchStructure();
+        return true;
+    }
+
+    void LayerStack::RemapTextureAtlases(const std::vector<int32_t>& atlasRemap)
+    {
+        std::vector<uint16_t> indexRemap = m_Palette->RemapAtlases(atlasRemap);
+
+        // Tiles keep their palette indices but may now render differently, unless entries were merged
+        if (indexRemap.empty())
+        {
+            for (auto& layer : m_Layers)
+            {
+                layer.Invalidate();
+            }
+            return;
+        }
+
+        WorkerPool::Get().ParallelFor(m_Layers.size(), [&](size_t i)
+            {
+                m_Layers[i].RemapTileIndices(indexRemap);
+            });
+    }
+
+    size_t LayerStack::CountAtlasUsage(size_t atlasIndex, const glm::vec4* textureCoords) const
+    {
+        size_t count = 0;
+        for (const auto& layer : m_Layers)
+        {
+            for (const TileLayer::ChunkUsage& usage : layer.FindAtlasUsage(atlasIndex, textureCoords))
+            {
+                count += usage.TileCount;
+            }
+        }
+        return count;
+    }
+
+    uint64_t LayerStack::GetGeneration() const
+    {
+        uint64_t generation = m_StructureGeneration;
+        for (const auto& layer : m_Layers)
+        {
+            generation = std::max(generation, layer.GetGeneration());
+        }
+        return generation;
+    }
+
+    TileLayer LayerStack::CreateLayer() const
+    {
+        TileLayer layer(m_Width, m_Height, m_Palette);
+        layer.SetUnbounded(m_Unbounded);
+        return layer;
     }
 
     TileLayer& LayerStack::GetLayer(size_t index)
@@ -182,79 +292,67 @@ namespace Tiles
         return m_Layers[index];
     }
 
-    Tile& LayerStack::GetTile(size_t x, size_t y, size_t index)
+    Tile LayerStack::GetTile(int32_t x, int32_t y, size_t index) const
     {
         LUMINA_ASSERT(IsValidLayerIndex(index), "LayerStack::GetTile: Invalid layer index {} (layer count: {})", index, m_Layers.size());
         return m_Layers[index].GetTile(x, y);
     }
 
-    const Tile& LayerStack::GetTile(size_t x, size_t y, size_t index) const
+    void LayerStack::SetTile(int32_t x, int32_t y, size_t index, const Tile& tile)
     {
-        LUMINA_ASSERT(IsValidLayerIndex(index), "LayerStack::GetTile: Invalid layer index {} (layer count: {})", index, m_Layers.size());
-        return m_Layers[index].GetTile(x, y);
+        LUMINA_ASSERT(IsValidLayerIndex(index), "LayerStack::SetTile: Invalid layer index {} (layer count: {})", index, m_Layers.size());
+        m_Layers[index].SetTile(x, y, tile);
     }
 
-    nlohmann::json LayerStack::ToJSON() const
+    TileRegion LayerStack::CopyRegion(size_t index, const TileBounds& bounds) const
     {
-        nlohmann::json jsonLayerStack;
-
-        jsonLayerStack[JSON::LayerStack::Width] = GetWidth();
-        jsonLayerStack[JSON::LayerStack::Height] = GetHeight();
-
-        nlohmann::json layersArray = nlohmann::json::array();
-        for (const auto& layer : m_Layers)
-        {
-            layersArray.push_back(layer.ToJSON());
-        }
-        jsonLayerStack[JSON::LayerStack::TileLayers] = layersArray;
-
-        return jsonLayerStack;
+        LUMINA_ASSERT(IsValidLayerIndex(index), "LayerStack::CopyRegion: Invalid layer index {} (layer count: {})", index, m_Layers.size());
+        return m_Layers[index].CopyRegion(bounds);
     }
 
-    LayerStack LayerStack::FromJSON(const nlohmann::json& jsonLayerStack)
+    void LayerStack::PasteRegion(size_t index, int32_t x, int32_t y, const TileRegion& region, const std::vector<uint8_t>& mask)
     {
-        if (!jsonLayerStack.contains(JSON::LayerStack::Width) || !jsonLayerStack.contains(JSON::LayerStack::Height))
-        {
-            LUMINA_LOG_INFO("LayerStack::FromJSON: JSON missing required Width or Height fields");
-            return LayerStack(0, 0);
-        }
-
-        uint32_t width = jsonLayerStack.at(JSON::LayerStack::Width).get<uint32_t>();
-        uint32_t height = jsonLayerStack.at(JSON::LayerStack::Height).get<uint32_t>();
+        LUMINA_ASSERT(IsValidLayerIndex(index), "LayerStack::PasteRegion: Invalid layer index {} (layer count: {})", index, m_Layers.size());
+        m_Layers[index].PasteRegion(x, y, region, mask);
+    }
 
-        LayerStack layerStack(width, height);
+    void LayerStack::FillRect(size_t index, const TileBounds& bounds, const Tile& tile)
+    {
+        LUMINA_ASSERT(IsValidLayerIndex(index), "LayerStack::FillRect: Invalid layer index {} (layer count: {})", index, m_Layers.size());
+        m_Layers[index].FillRect(bounds, tile);
+    }
 
-        if (jsonLayerStack.contains(JSON::LayerStack::TileLayers))
-        {
-            const auto& layersArray = jsonLayerStack[JSON::LayerStack::TileLayers];
-            size_t loadedCount = 0;
+    void LayerStack::Shift(int32_t dx, int32_t dy)
+    {
+        LUMINA_LOG_INFO("LayerStack::Shift: Shifting {} layers by ({}, {})", m_Layers.size(), dx, dy);
 
-            for (const auto& layerJson : layersArray)
+        // Shifting only moves existing palette indices, so layers can be processed independently
+        WorkerPool::Get().ParallelFor(m_Layers.size(), [&](size_t i)
             {
-                try
-                {
-                    TileLayer layer = TileLayer::FromJSON(layerJson);
-
-                    if (layer.GetWidth() != width || layer.GetHeight() != height)
-                    {
-                        layer.Resize(width, height);
-                    }
-
-                    layerStack.m_Layers.push_back(layer);
-                    loadedCount++;
-                }
-                catch (const std::exception& e)
-                {
-                    LUMINA_LOG_INFO("LayerStack::FromJSON: Failed to load layer: {}", e.what());
-                }
-            }
+                m_Layers[i].Shift(dx, dy);
+            });
+    }
 
-            if (loadedCount != layersArray.size())
-            {
-                LUMINA_LOG_INFO("LayerStack::FromJSON: Loaded {} out of {} layers", loadedCount, layersArray.size());
-            }
+    void LayerStack::WriteJSON(JsonWriter& writer) const
+    {
+        writer.BeginObject();
+        writer.Key(JSON::LayerStack::Width);
+        writer.UInt(m_Width);
+        writer.Key(JSON::LayerStack::Height);
+        writer.UInt(m_Height);
+        writer.Key(JSON::LayerStack::Unbounded);
+        writer.Bool(m_Unbounded);
+        writer.Key(JSON::LayerStack::Palette);
+        m_Palette->WriteJSON(writer);
+
+        writer.Key(JSON::LayerStack::TileLayers);
+        writer.BeginArray();
+        for (const auto& layer : m_Layers)
+        {
+            layer.WriteJSON(writer);
         }
-
-        return layerStack;
+        writer.EndArray();
+        writer.EndObject();
     }
+
 }
\ No newline at end of file
@@ -12,10 +12,10 @@ namespace Tiles
     class LayerStack
     {
     public:
-        nlohmann::json ToJSON() const;
-        static LayerStack FromJSON(const nlohmann::json& jsonLayerStack);
+        void WriteJSON(JsonWriter& writer) const;
 
-        LayerStack(uint32_t width = 0, uint32_t height = 0);
+        // Unbounded stacks ignore width and height, layers grow wherever tiles are painted
+        LayerStack(uint32_t width = 0, uint32_t height = 0, bool unbounded = false);
         ~LayerStack() = default;
 
         void AddLayer(const std::string& name = "New Layer");
@@ -32,15 +32,45 @@ namespace Tiles
         void Resize(uint32_t width, uint32_t height);
         bool IsEmpty() const { return m_Layers.empty(); }
 
-        uint32_t GetWidth() const { return m_Width; }
-        uint32_t GetHeight() const { return m_Height; }
+        // Unbounded stacks report the area covered by painted tiles across all layers
+        uint32_t GetWidth() const { return m_Unbounded ? GetBounds().GetWidth() : m_Width; }
+        uint32_t GetHeight() const { return m_Unbounded ? GetBounds().GetHeight() : m_Height; }
+        TileBounds GetBounds() const;
+        bool IsUnbounded() const { return m_Unbounded; }
         size_t GetLayerCount() const { return m_Layers.size(); }
 
+        // Generation of the last change to the layer list or stack size, layer contents track their own
+        uint64_t GetStructureGeneration() const { return m_StructureGeneration; }
+
+        // Latest generation of the stack or any of its layers
+        uint64_t GetGeneration() const;
+
+        // Every layer in the stack shares this palette, so palette indices compare across layers
+        const Ref<TilePalette>& GetPalette() const { return m_Palette; }
+
+        // Moves every layer onto another palette, see TileLayer::SetPalette. Returns false and leaves
+        // the stack unchanged when the palette has no room for the tiles it is missing.
+        bool SetPalette(const Ref<TilePalette>& palette);
+
+        // Follows a change to the project atlas list, see TilePalette::RemapAtlases
+        void RemapTextureAtlases(const std::vector<int32_t>& atlasRemap);
+
+        // Number of tiles across all layers textured from an atlas, or only from one atlas cell
+        size_t CountAtlasUsage(size_t atlasIndex, const glm::vec4* textureCoords = nullptr) const;
+
         TileLayer& GetLayer(size_t index);
         const TileLayer& GetLayer(size_t index) const;
 
-        Tile& GetTile(size_t x, size_t y, size_t index);
-        const Tile& GetTile(size_t x, size_t y, size_t index) const;
+        Tile GetTile(int32_t x, int32_t y, size_t index) const;
+        void SetTile(int32_t x, int32_t y, size_t index, const Tile& tile);
+
+        // Rectangle operations on a single layer, see TileLayer
+        TileRegion CopyRegion(size_t index, const TileBounds& bounds) const;
+        void PasteRegion(size_t index, int32_t x, int32_t y, const TileRegion& region, const std::vector<uint8_t>& mask = {});
+        void FillRect(size_t index, const TileBounds& bounds, const Tile& tile);
+
+        // Scrolls the contents of every layer by (dx, dy)
+        void Shift(int32_t dx, int32_t dy);
 
         auto begin() { return m_Layers.begin(); }
         auto end() { return m_Layers.end(); }
@@ -49,9 +79,19 @@ namespace Tiles
 
         bool IsValidLayerIndex(size_t index) const { return index >= 0 && index < m_Layers.size(); }
     
+    private:
+        friend class ProjectFile;
+        friend class ProjectJSONReader;
+
+        TileLayer CreateLayer() const;
+        void TouchStructure() { m_StructureGeneration = TileLayer::NextGeneration(); }
+
     private:
         uint32_t m_Width = 16;                          // Width of the layer stack in tiles
         uint32_t m_Height = 16;                         // Height of the layer stack in tiles
+        bool m_Unbounded = false;                       // Whether layers accept tiles at any coordinate
+        Ref<TilePalette> m_Palette;                     // Tile variants shared by all layers
         std::vector<TileLayer> m_Layers;                // Collection of tile layers ordered from bottom to top
+        uint64_t m_StructureGeneration = 0;             // Generation of the last add, remove, reorder or resize
     };
 }
\ No newline at end of file
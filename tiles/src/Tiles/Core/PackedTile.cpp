@@ -0,0 +1,128 @@
+#include "PackedTile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Lumina/Core/Assert.h"
+
+namespace Tiles
+{
+    namespace
+    {
+        uint8_t QuantizeUnorm8(float value)
+        {
+            return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+        }
+
+        uint16_t QuantizeTextureCoord(float value)
+        {
+            return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * PackedTile::TEXTURE_COORD_SCALE));
+        }
+
+        uint8_t QuantizeSize(float value)
+        {
+            return static_cast<uint8_t>(std::lround(std::clamp(value * PackedTile::SIZE_SCALE, 0.0f, 255.0f)));
+        }
+
+        // Number of whole steps of the given angle, wrapped into [0, count)
+        uint32_t QuantizeAngle(float degrees, float step, int32_t count)
+        {
+            int32_t steps = static_cast<int32_t>(std::lround(degrees / step)) % count;
+            return static_cast<uint32_t>(steps < 0 ? steps + count : steps);
+        }
+    }
+
+    PackedTile PackedTile::FromTile(const Tile& tile)
+    {
+        PackedTile packed;
+        if (!tile.IsPainted())
+            return packed;
+
+        packed.Flags |= FLAG_PAINTED;
+        if (tile.IsTextured())
+            packed.Flags |= FLAG_TEXTURED;
+
+        const glm::vec3& rotation = tile.GetRotation();
+        if (QuantizeAngle(rotation.x, 180.0f, 2) != 0)
+            packed.Flags |= FLAG_FLIP_Y;
+        if (QuantizeAngle(rotation.y, 180.0f, 2) != 0)
+            packed.Flags |= FLAG_FLIP_X;
+        packed.Flags |= static_cast<uint8_t>(QuantizeAngle(rotation.z, 90.0f, 4) << ROTATION_SHIFT);
+
+        // Projects hold at most MAX_ATLAS_COUNT atlases, see Project::AddTextureAtlas
+        if (tile.HasValidAtlas())
+        {
+            LUMINA_ASSERT(tile.GetAtlasIndex() < MAX_ATLAS_COUNT, "PackedTile::FromTile: Atlas index {} does not fit in a packed tile", tile.GetAtlasIndex());
+            if (tile.GetAtlasIndex() < MAX_ATLAS_COUNT)
+                packed.AtlasIndex = static_cast<uint8_t>(tile.GetAtlasIndex());
+        }
+
+        const glm::vec4& textureCoords = tile.GetTextureCoords();
+        for (int i = 0; i < 4; i++)
+            packed.TextureCoords[i] = QuantizeTextureCoord(textureCoords[i]);
+
+        const glm::vec4& tint = tile.GetTint();
+        packed.Tint = static_cast<uint32_t>(QuantizeUnorm8(tint.r))
+            | static_cast<uint32_t>(QuantizeUnorm8(tint.g)) << 8
+            | static_cast<uint32_t>(QuantizeUnorm8(tint.b)) << 16
+            | static_cast<uint32_t>(QuantizeUnorm8(tint.a)) << 24;
+
+        const glm::vec2& size = tile.GetSize();
+        packed.Size[0] = QuantizeSize(size.x);
+        packed.Size[1] = QuantizeSize(size.y);
+
+        return packed;
+    }
+
+    Tile PackedTile::ToTile() const
+    {
+        Tile tile;
+        if (!IsPainted())
+            return tile;
+
+        tile.SetPainted(true);
+        tile.SetTextured(IsTextured());
+        tile.SetAtlasIndex(AtlasIndex == INVALID_ATLAS_INDEX ? Tile::INVALID_ATLAS_INDEX : AtlasIndex);
+
+        tile.SetRotation({
+            (Flags & FLAG_FLIP_Y) ? 180.0f : 0.0f,
+            (Flags & FLAG_FLIP_X) ? 180.0f : 0.0f,
+            GetQuarterTurns() * 90.0f
+            });
+
+        tile.SetTextureCoords({
+            TextureCoords[0] / TEXTURE_COORD_SCALE,
+            TextureCoords[1] / TEXTURE_COORD_SCALE,
+            TextureCoords[2] / TEXTURE_COORD_SCALE,
+            TextureCoords[3] / TEXTURE_COORD_SCALE
+            });
+
+        tile.SetTint({
+            (Tint & 0xFF) / 255.0f,
+            ((Tint >> 8) & 0xFF) / 255.0f,
+            ((Tint >> 16) & 0xFF) / 255.0f,
+            ((Tint >> 24) & 0xFF) / 255.0f
+            });
+
+        tile.SetSize({ Size[0] / SIZE_SCALE, Size[1] / SIZE_SCALE });
+
+        return tile;
+    }
+
+    bool PackedTile::operator==(const PackedTile& other) const
+    {
+        return std::memcmp(this, &other, sizeof(PackedTile)) == 0;
+    }
+
+    size_t PackedTile::GetHash() const
+    {
+        uint64_t words[2];
+        std::memcpy(words, this, sizeof(words));
+
+        uint64_t hash = words[0] * 0x9E3779B97F4A7C15ull;
+        hash ^= (words[1] + 0x632BE59BD9B4E019ull) + (hash << 6) + (hash >> 2);
+        hash ^= hash >> 31;
+        return static_cast<size_t>(hash);
+    }
+}
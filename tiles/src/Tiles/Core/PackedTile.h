@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "Tile.h"
+
+namespace Tiles
+{
+    // Compact 16 byte storage form of a Tile used by TileLayer. Tint is quantized to RGBA8,
+    // texture coords to 1/32768th steps (exact for power of two atlas grids), size to 1/50th
+    // steps and rotation to 90 degree turns plus flip bits.
+    struct PackedTile
+    {
+        static constexpr uint8_t FLAG_PAINTED = 1 << 0;
+        static constexpr uint8_t FLAG_TEXTURED = 1 << 1;
+        static constexpr uint8_t FLAG_FLIP_X = 1 << 2;             // 180 degree rotation around Y
+        static constexpr uint8_t FLAG_FLIP_Y = 1 << 3;             // 180 degree rotation around X
+        static constexpr uint8_t ROTATION_SHIFT = 4;               // Quarter turns around Z in bits 4-5
+        static constexpr uint8_t ROTATION_MASK = 0x3 << ROTATION_SHIFT;
+
+        static constexpr uint8_t INVALID_ATLAS_INDEX = UINT8_MAX;
+        static constexpr size_t MAX_ATLAS_COUNT = INVALID_ATLAS_INDEX;             // Atlas indices 0-254 fit next to the invalid marker
+        static constexpr float SIZE_SCALE = 50.0f;
+        static constexpr uint8_t SIZE_ONE = 50;
+        static constexpr float TEXTURE_COORD_SCALE = 32768.0f;
+        static constexpr uint16_t TEXTURE_COORD_ONE = 32768;
+
+        uint16_t TextureCoords[4] = { 0, 0, TEXTURE_COORD_ONE, TEXTURE_COORD_ONE };  // u0, v0, u1, v1 in 1.15 fixed point
+        uint32_t Tint = UINT32_MAX;                                                  // RGBA8, red in the low byte
+        uint8_t AtlasIndex = INVALID_ATLAS_INDEX;                                    // Index into the project atlases
+        uint8_t Flags = 0;                                                           // Painted, textured, flips and rotation
+        uint8_t Size[2] = { SIZE_ONE, SIZE_ONE };                                    // Width and height multipliers
+
+        bool IsPainted() const { return (Flags & FLAG_PAINTED) != 0; }
+        bool IsTextured() const { return (Flags & FLAG_TEXTURED) != 0; }
+        bool IsDefault() const { return *this == PackedTile(); }
+
+        uint32_t GetQuarterTurns() const { return (Flags & ROTATION_MASK) >> ROTATION_SHIFT; }
+
+        // Unpainted tiles are never rendered, so they all pack to the default value.
+        static PackedTile FromTile(const Tile& tile);
+        Tile ToTile() const;
+
+        bool operator==(const PackedTile& other) const;
+        bool operator!=(const PackedTile& other) const { return !(*this == other); }
+
+        // Mixes the two 64 bit words of the packed form
+        size_t GetHash() const;
+    };
+
+    static_assert(sizeof(PackedTile) == 16, "PackedTile must stay 16 bytes");
+}
+
+namespace std
+{
+    template<>
+    struct hash<Tiles::PackedTile>
+    {
+        size_t operator()(const Tiles::PackedTile& tile) const { return tile.GetHash(); }
+    };
+}
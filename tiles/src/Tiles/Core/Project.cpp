@@ -10,9 +10,9 @@
 
 namespace Tiles
 {
-    Project::Project(uint32_t width, uint32_t height, const std::string& name) : m_ProjectName(name), m_LayerStack(width, height)
+    Project::Project(uint32_t width, uint32_t height, const std::string& name, bool unbounded) : m_ProjectName(name), m_LayerStack(width, height, unbounded)
     {
-        LUMINA_LOG_INFO("Project::Project: Creating new project: '{}' with dimensions {}x{}", name, width, height);
+        LUMINA_LOG_INFO("Project::Project: Creating new project: '{}' with dimensions {}x{}{}", name, width, height, unbounded ? " (unbounded)" : "");
         UpdateLastAccessed();
     }
 
@@ -40,6 +40,13 @@ namespace Tiles
             return;
         }
 
+        // Packed tiles store the atlas index in a byte
+        if (m_TextureAtlases.size() >= PackedTile::MAX_ATLAS_COUNT)
+        {
+            LUMINA_LOG_INFO("Project::AddTextureAtlas: Projects hold at most {} texture atlases - ignoring", PackedTile::MAX_ATLAS_COUNT);
+            return;
+        }
+
         m_TextureAtlases.push_back(atlas);
         LUMINA_LOG_INFO("Project::AddTextureAtlas: Added texture atlas (total count: {})", m_TextureAtlases.size());
         MarkAsModified();
@@ -59,99 +66,96 @@ namespace Tiles
             return;
         }
 
+        // Tiles of the removed atlas lose their texture, tiles of later atlases follow them down one slot
+        std::vector<int32_t> atlasRemap(m_TextureAtlases.size());
+        for (size_t i = 0; i < atlasRemap.size(); i++)
+        {
+            atlasRemap[i] = i < index ? static_cast<int32_t>(i) : static_cast<int32_t>(i) - 1;
+        }
+        atlasRemap[index] = -1;
+
         m_TextureAtlases.erase(m_TextureAtlases.begin() + index);
+        m_LayerStack.RemapTextureAtlases(atlasRemap);
         LUMINA_LOG_INFO("Project::RemoveTextureAtlas: Removed texture atlas at index {} (remaining count: {})", index, m_TextureAtlases.size());
         MarkAsModified();
     }
 
-    void Project::ClearTextureAtlases()
+    void Project::MoveTextureAtlas(size_t fromIndex, size_t toIndex)
     {
-        size_t previousCount = m_TextureAtlases.size();
-        m_TextureAtlases.clear();
-        LUMINA_LOG_INFO("Project::ClearTextureAtlases: Cleared {} texture atlases", previousCount);
-        MarkAsModified();
-    }
+        if (fromIndex >= m_TextureAtlases.size() || toIndex >= m_TextureAtlases.size())
+        {
+            LUMINA_LOG_INFO("Project::MoveTextureAtlas: Attempted to move texture atlas from {} to {} (size: {})", fromIndex, toIndex, m_TextureAtlases.size());
+            return;
+        }
 
-    nlohmann::json Project::ToJSON() const
-    {
-        LUMINA_LOG_INFO("Project::ToJSON: Serializing project '{}' to JSON", m_ProjectName);
+        if (fromIndex == toIndex)
+            return;
 
-        nlohmann::json jsonProject;
+        std::vector<int32_t> atlasRemap(m_TextureAtlases.size());
+        for (size_t i = 0; i < atlasRemap.size(); i++)
+        {
+            atlasRemap[i] = static_cast<int32_t>(i);
+        }
 
-        jsonProject[JSON::Project::Name] = GetProjectName();
-        jsonProject[JSON::Project::LayerStack] = GetLayerStack().ToJSON();
+        auto atlas = m_TextureAtlases[fromIndex];
+        m_TextureAtlases.erase(m_TextureAtlases.begin() + fromIndex);
+        m_TextureAtlases.insert(m_TextureAtlases.begin() + toIndex, atlas);
 
-        nlohmann::json atlasArray = nlohmann::json::array();
-        for (const auto& atlas : GetTextureAtlases())
+        // Atlases between the two positions shift one slot towards fromIndex
+        if (fromIndex < toIndex)
         {
-            if (atlas && atlas->GetTexture())
-            {
-                nlohmann::json jsonAtlas;
-                jsonAtlas[JSON::Atlas::Path] = atlas->GetTexture()->GetPath();
-                jsonAtlas[JSON::Atlas::Width] = atlas->GetWidth();
-                jsonAtlas[JSON::Atlas::Height] = atlas->GetHeight();
-                atlasArray.push_back(jsonAtlas);
-            }
+            for (size_t i = fromIndex + 1; i <= toIndex; i++)
+                atlasRemap[i] = static_cast<int32_t>(i) - 1;
         }
-        jsonProject[JSON::Atlas::Array] = atlasArray;
-
-        LUMINA_LOG_INFO("Project::ToJSON: Serialized project with {} texture atlases", GetTextureAtlases().size());
+        else
+        {
+            for (size_t i = toIndex; i < fromIndex; i++)
+                atlasRemap[i] = static_cast<int32_t>(i) + 1;
+        }
+        atlasRemap[fromIndex] = static_cast<int32_t>(toIndex);
 
-        return jsonProject;
+        m_LayerStack.RemapTextureAtlases(atlasRemap);
+        LUMINA_LOG_INFO("Project::MoveTextureAtlas: Moved texture atlas from index {} to {}", fromIndex, toIndex);
+        MarkAsModified();
     }
 
-    Ref<Project> Project::FromJSON(const nlohmann::json& json)
+    void Project::ClearTextureAtlases()
     {
-        LUMINA_LOG_INFO("Project::FromJSON: Loading project from JSON");
-
-        if (!json.contains(JSON::Project::LayerStack))
-        {
-            LUMINA_LOG_INFO("Project::FromJSON: JSON missing required LayerStack field");
-            return nullptr;
-        }
-
-        LayerStack layerStack = LayerStack::FromJSON(json.at(JSON::Project::LayerStack));
-        std::string projectName = json.value(JSON::Project::Name, "Loaded Project");
+        size_t previousCount = m_TextureAtlases.size();
+        m_TextureAtlases.clear();
+        m_LayerStack.RemapTextureAtlases(std::vector<int32_t>(previousCount, -1));
+        LUMINA_LOG_INFO("Project::ClearTextureAtlases: Cleared {} texture atlases", previousCount);
+        MarkAsModified();
+    }
 
-        LUMINA_LOG_INFO("Project::FromJSON: Creating project '{}' with dimensions {}x{}", projectName, layerStack.GetWidth(), layerStack.GetHeight());
+    void Project::WriteJSON(JsonWriter& writer) const
+    {
+        LUMINA_LOG_INFO("Project::WriteJSON: Serializing project '{}' to JSON", m_ProjectName);
 
-        Ref<Project> project = CreateRef<Project>(layerStack.GetWidth(), layerStack.GetHeight(), projectName);
-        project->m_LayerStack = layerStack;
+        writer.BeginObject();
+        writer.Key(JSON::Project::Name);
+        writer.String(GetProjectName());
+        writer.Key(JSON::Project::LayerStack);
+        GetLayerStack().WriteJSON(writer);
 
-        if (json.contains(JSON::Atlas::Array))
+        writer.Key(JSON::Atlas::Array);
+        writer.BeginArray();
+        // Atlases without a texture keep their slot with an empty path, tiles refer to atlases by position
+        for (const auto& atlas : GetTextureAtlases())
         {
-            const auto& atlasesArray = json[JSON::Atlas::Array];
-            project->m_TextureAtlases.reserve(atlasesArray.size());
-
-            size_t loadedCount = 0;
-            for (const auto& jsonAtlas : atlasesArray)
-            {
-                std::string texturePath = jsonAtlas.value(JSON::Atlas::Path, "");
-                uint32_t atlasWidth = jsonAtlas.value(JSON::Atlas::Width, 0);
-                uint32_t atlasHeight = jsonAtlas.value(JSON::Atlas::Height, 0);
-
-                if (texturePath.empty() || atlasWidth == 0 || atlasHeight == 0)
-                {
-                    LUMINA_LOG_INFO("Project::FromJSON: Skipping invalid atlas entry: path='{}', width={}, height={}", texturePath, atlasWidth, atlasHeight);
-                    continue;
-                }
-
-                auto atlas = Lumina::TextureAtlas::Create(texturePath, atlasWidth, atlasHeight);
-                if (atlas)
-                {
-                    project->m_TextureAtlases.push_back(atlas);
-                    loadedCount++;
-                }
-                else
-                {
-                    LUMINA_LOG_INFO("Project::FromJSON: Failed to create texture atlas from path: {}", texturePath);
-                }
-            }
-
-            LUMINA_LOG_INFO("Project::FromJSON: Loaded {} texture atlases (attempted {})", loadedCount, atlasesArray.size());
+            writer.BeginObject();
+            writer.Key(JSON::Atlas::Path);
+            writer.String(atlas->HasTexture() ? atlas->GetTexture()->GetPath() : std::string());
+            writer.Key(JSON::Atlas::Width);
+            writer.UInt(atlas->GetWidth());
+            writer.Key(JSON::Atlas::Height);
+            writer.UInt(atlas->GetHeight());
+            writer.EndObject();
         }
+        writer.EndArray();
+        writer.EndObject();
 
-        LUMINA_LOG_INFO("Project::FromJSON: Project '{}' loaded successfully", projectName);
-        return project;
+        LUMINA_LOG_INFO("Project::WriteJSON: Serialized project with {} texture atlases", GetTextureAtlases().size());
     }
+
 }
\ No newline at end of file
@@ -20,10 +20,10 @@ namespace Tiles
     class Project
     {
     public:
-        nlohmann::json ToJSON() const;
-        static Ref<Project> FromJSON(const nlohmann::json& json);
+        // Streams the project as JSON, memory use does not grow with the number of tiles
+        void WriteJSON(JsonWriter& writer) const;
 
-        Project(uint32_t width, uint32_t height, const std::string& name = "Untitled Project");
+        Project(uint32_t width, uint32_t height, const std::string& name = "Untitled Project", bool unbounded = false);
         ~Project() = default;
 
         const std::string& GetProjectName() const { return m_ProjectName; }
@@ -47,9 +47,12 @@ namespace Tiles
         LayerStack& GetLayerStack() { return m_LayerStack; }
         const LayerStack& GetLayerStack() const { return m_LayerStack; }
 
+        // Ignored once the project holds PackedTile::MAX_ATLAS_COUNT atlases, see CanAddTextureAtlas
         void AddTextureAtlas(Ref<Lumina::TextureAtlas> atlas);
+        bool CanAddTextureAtlas() const { return m_TextureAtlases.size() < PackedTile::MAX_ATLAS_COUNT; }
         Ref<Lumina::TextureAtlas> GetTextureAtlas(size_t index); 
         void RemoveTextureAtlas(size_t index);
+        void MoveTextureAtlas(size_t fromIndex, size_t toIndex);
         void ClearTextureAtlases();
         size_t GetTextureAtlasCount() const { return m_TextureAtlases.size(); }
 
@@ -0,0 +1,561 @@
+#include "ProjectFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "BitUtils.h"
+#include "LZ.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
+
+#include "Lumina/Core/Log.h"
+
+namespace Tiles
+{
+    namespace
+    {
+        constexpr char MAGIC[8] = { 'T', 'I', 'L', 'E', 'S', 'B', 'I', 'N' };
+        constexpr uint64_t TABLE_ALIGNMENT = 8;
+        constexpr uint32_t RAW_BLOCK_SIZE = TileChunk::TILE_COUNT * sizeof(uint16_t);
+        constexpr uint32_t ROW_MASKS_SIZE = TileChunk::SIZE * sizeof(uint32_t);
+
+        // Chunks handed to the WorkerPool at once, bounds the scratch blocks held during save and load
+        constexpr size_t CHUNK_BATCH_SIZE = 1024;
+
+        // Largest valid block before compression, a run block with one run per tile
+        constexpr uint32_t MAX_DECOMPRESSED_SIZE = TileChunk::TILE_COUNT * 2 * sizeof(uint16_t);
+
+        uint64_t Align(uint64_t offset, uint64_t alignment)
+        {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        // Appends a string to the string bytes and returns where it went
+        std::pair<uint32_t, uint32_t> AddString(std::vector<char>& strings, const std::string& value)
+        {
+            uint32_t offset = static_cast<uint32_t>(strings.size());
+            strings.insert(strings.end(), value.begin(), value.end());
+            return { offset, static_cast<uint32_t>(value.size()) };
+        }
+    }
+
+    size_t ProjectFile::Save(const Project& project, const std::filesystem::path& path)
+    {
+        static_assert(sizeof(Header) == 112 && sizeof(LayerRecord) == 24 && sizeof(ChunkRecord) == 24 && sizeof(AtlasRecord) == 16, "ProjectFile records must not change size");
+
+        const LayerStack& layerStack = project.GetLayerStack();
+        const TilePalette& palette = *layerStack.GetPalette();
+
+        std::vector<char> strings;
+        std::vector<LayerRecord> layerRecords;
+        std::vector<ChunkRecord> chunkRecords;
+        std::vector<const TileChunk*> chunks;                   // Parallel to chunkRecords
+        std::vector<uint8_t> chunkBlocks;
+        std::vector<AtlasRecord> atlasRecords;
+
+        Header header = {};
+        std::memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+        header.Version = VERSION;
+        header.Flags = layerStack.IsUnbounded() ? FLAG_UNBOUNDED : 0;
+        header.Width = layerStack.m_Width;
+        header.Height = layerStack.m_Height;
+        std::tie(header.NameOffset, header.NameLength) = AddString(strings, project.GetProjectName());
+
+        for (const TileLayer& layer : layerStack)
+        {
+            LayerRecord layerRecord = {};
+            std::tie(layerRecord.NameOffset, layerRecord.NameLength) = AddString(strings, layer.GetName());
+            layerRecord.RenderGroup = static_cast<int32_t>(layer.GetRenderGroup());
+            layerRecord.Flags = layer.GetVisibility() ? LAYER_VISIBLE : 0;
+            layerRecord.FirstChunk = static_cast<uint32_t>(chunkRecords.size());
+
+            // Row-major chunk order keeps neighbouring chunks close together in the file
+            std::vector<std::pair<ChunkRecord, const TileChunk*>> layerChunks;
+            layerChunks.reserve(layer.GetAllocatedChunkCount());
+            layer.ForEachChunk([&](int32_t chunkX, int32_t chunkY, const TileChunk& chunk)
+                {
+                    ChunkRecord chunkRecord = {};
+                    chunkRecord.ChunkX = chunkX;
+                    chunkRecord.ChunkY = chunkY;
+                    layerChunks.push_back({ chunkRecord, &chunk });
+                });
+            std::sort(layerChunks.begin(), layerChunks.end(), [](const auto& a, const auto& b)
+                {
+                    return std::tie(a.first.ChunkY, a.first.ChunkX) < std::tie(b.first.ChunkY, b.first.ChunkX);
+                });
+
+            for (const auto& [chunkRecord, chunk] : layerChunks)
+            {
+                chunkRecords.push_back(chunkRecord);
+                chunks.push_back(chunk);
+            }
+
+            layerRecord.ChunkCount = static_cast<uint32_t>(chunkRecords.size()) - layerRecord.FirstChunk;
+            layerRecords.push_back(layerRecord);
+        }
+
+        // Entries no chunk refers to are left out, the rest keep their order
+        std::vector<uint8_t> usedEntries(palette.GetEntryCount(), 0);
+        usedEntries[TilePalette::DEFAULT_INDEX] = 1;
+        for (const TileChunk* chunk : chunks)
+        {
+            const uint16_t* tileIndices = chunk->GetTileIndices().GetData();
+            for (uint32_t i = 0; i < TileChunk::TILE_COUNT; i++)
+            {
+                usedEntries[tileIndices[i]] = 1;
+            }
+        }
+
+        std::vector<uint16_t> indexRemap(palette.GetEntryCount());
+        std::vector<uint16_t> savedEntries;
+        for (size_t i = 0; i < palette.GetEntryCount(); i++)
+        {
+            indexRemap[i] = static_cast<uint16_t>(savedEntries.size());
+            if (usedEntries[i])
+                savedEntries.push_back(static_cast<uint16_t>(i));
+        }
+        const size_t droppedCount = palette.GetEntryCount() - savedEntries.size();
+        const uint16_t* chunkRemap = droppedCount > 0 ? indexRemap.data() : nullptr;
+
+        // Chunks are encoded in parallel one batch at a time and appended in table order. Block
+        // offsets are relative to the chunk blocks until the layout is known.
+        std::vector<std::array<uint8_t, RAW_BLOCK_SIZE>> batchBlocks(std::min(chunks.size(), CHUNK_BATCH_SIZE));
+        for (size_t batchStart = 0; batchStart < chunks.size(); batchStart += CHUNK_BATCH_SIZE)
+        {
+            const size_t batchCount = std::min(CHUNK_BATCH_SIZE, chunks.size() - batchStart);
+            WorkerPool::Get().ParallelFor(batchCount, [&](size_t i)
+                {
+                    ChunkRecord& chunkRecord = chunkRecords[batchStart + i];
+                    chunkRecord.Encoding = EncodeChunk(*chunks[batchStart + i], chunkRemap, batchBlocks[i].data(), chunkRecord.BlockSize);
+                });
+
+            for (size_t i = 0; i < batchCount; i++)
+            {
+                ChunkRecord& chunkRecord = chunkRecords[batchStart + i];
+                chunkRecord.BlockOffset = chunkBlocks.size();
+                chunkBlocks.insert(chunkBlocks.end(), batchBlocks[i].data(), batchBlocks[i].data() + chunkRecord.BlockSize);
+            }
+        }
+
+        // Atlases without a texture are saved too, palette entries refer to atlases by position
+        for (const auto& atlas : project.GetTextureAtlases())
+        {
+            AtlasRecord atlasRecord = {};
+            if (atlas->HasTexture())
+            {
+                std::tie(atlasRecord.PathOffset, atlasRecord.PathLength) = AddString(strings, atlas->GetTexture()->GetPath());
+            }
+            atlasRecord.Width = atlas->GetWidth();
+            atlasRecord.Height = atlas->GetHeight();
+            atlasRecords.push_back(atlasRecord);
+        }
+
+        header.PaletteEntryCount = static_cast<uint32_t>(savedEntries.size() - 1);
+        header.LayerCount = static_cast<uint32_t>(layerRecords.size());
+        header.ChunkCount = static_cast<uint32_t>(chunkRecords.size());
+        header.AtlasCount = static_cast<uint32_t>(atlasRecords.size());
+
+        uint64_t offset = sizeof(Header);
+        header.PaletteOffset = offset;
+        offset = Align(offset + uint64_t(header.PaletteEntryCount) * sizeof(PackedTile), TABLE_ALIGNMENT);
+        header.LayerTableOffset = offset;
+        offset = Align(offset + layerRecords.size() * sizeof(LayerRecord), TABLE_ALIGNMENT);
+        header.ChunkTableOffset = offset;
+        offset = Align(offset + chunkRecords.size() * sizeof(ChunkRecord), TABLE_ALIGNMENT);
+        header.AtlasTableOffset = offset;
+        offset = Align(offset + atlasRecords.size() * sizeof(AtlasRecord), TABLE_ALIGNMENT);
+        header.StringsOffset = offset;
+        header.StringsSize = strings.size();
+        header.ChunkBlocksOffset = Align(offset + strings.size(), TABLE_ALIGNMENT);
+        header.FileSize = header.ChunkBlocksOffset + chunkBlocks.size();
+
+        for (ChunkRecord& chunkRecord : chunkRecords)
+        {
+            chunkRecord.BlockOffset += header.ChunkBlocksOffset;
+        }
+
+        std::filesystem::path temporaryPath = path;
+        temporaryPath += ".tmp";
+
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open '" + temporaryPath.string() + "' for writing");
+
+        uint64_t position = 0;
+        auto write = [&](const void* data, uint64_t size)
+            {
+                file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+                position += size;
+            };
+        auto padTo = [&](uint64_t target)
+            {
+                static const std::array<char, TABLE_ALIGNMENT> zeros = {};
+                write(zeros.data(), target - position);
+            };
+
+        write(&header, sizeof(Header));
+        for (size_t i = 1; i < savedEntries.size(); i++)
+        {
+            write(&palette.GetPackedTile(savedEntries[i]), sizeof(PackedTile));
+        }
+        padTo(header.LayerTableOffset);
+        write(layerRecords.data(), layerRecords.size() * sizeof(LayerRecord));
+        padTo(header.ChunkTableOffset);
+        write(chunkRecords.data(), chunkRecords.size() * sizeof(ChunkRecord));
+        padTo(header.AtlasTableOffset);
+        write(atlasRecords.data(), atlasRecords.size() * sizeof(AtlasRecord));
+        padTo(header.StringsOffset);
+        write(strings.data(), strings.size());
+        padTo(header.ChunkBlocksOffset);
+        write(chunkBlocks.data(), chunkBlocks.size());
+
+        file.close();
+        if (!file)
+        {
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            throw std::runtime_error("Failed to write '" + temporaryPath.string() + "'");
+        }
+
+        std::filesystem::rename(temporaryPath, path);
+
+        LUMINA_LOG_INFO("ProjectFile::Save: Wrote {} layers, {} chunks and {} palette entries ({} bytes, {} unused entries left out)", header.LayerCount, header.ChunkCount, header.PaletteEntryCount, header.FileSize, droppedCount);
+        return droppedCount;
+    }
+
+    Ref<Project> ProjectFile::Load(const std::filesystem::path& path)
+    {
+        MappedFile file;
+        if (!file.Open(path))
+            throw std::runtime_error("Failed to open '" + path.string() + "'");
+
+        const uint8_t* data = file.GetData();
+        const uint64_t size = file.GetSize();
+
+        Header header;
+        if (size < sizeof(Header))
+            throw std::runtime_error("File is too small to be a project");
+        std::memcpy(&header, data, sizeof(Header));
+
+        if (std::memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0)
+            throw std::runtime_error("Not a binary project file");
+        if (header.Version > VERSION)
+            throw std::runtime_error("Project was saved by a newer version (" + std::to_string(header.Version) + ")");
+        if (header.FileSize != size)
+            throw std::runtime_error("File is truncated");
+
+        // Every table has to lie inside the file before anything is read from it
+        auto getRange = [&](uint64_t offset, uint64_t count, uint64_t elementSize) -> const uint8_t*
+            {
+                if (offset > size || count > (size - offset) / elementSize)
+                    throw std::runtime_error("Table out of range");
+                return data + offset;
+            };
+
+        const char* strings = reinterpret_cast<const char*>(getRange(header.StringsOffset, header.StringsSize, 1));
+        auto getString = [&](uint32_t offset, uint32_t length)
+            {
+                if (offset > header.StringsSize || length > header.StringsSize - offset)
+                    throw std::runtime_error("String out of range");
+                return std::string(strings + offset, length);
+            };
+
+        const uint8_t* paletteTable = getRange(header.PaletteOffset, header.PaletteEntryCount, sizeof(PackedTile));
+        std::vector<PackedTile> paletteEntries(header.PaletteEntryCount);
+        if (!paletteEntries.empty())
+        {
+            std::memcpy(paletteEntries.data(), paletteTable, paletteEntries.size() * sizeof(PackedTile));
+        }
+        Ref<TilePalette> palette = TilePalette::FromPackedTiles(paletteEntries.data(), paletteEntries.size());
+        const size_t paletteEntryCount = palette->GetEntryCount();
+
+        const bool unbounded = (header.Flags & FLAG_UNBOUNDED) != 0;
+        LayerStack layerStack(header.Width, header.Height, unbounded);
+        layerStack.m_Palette = palette;
+
+        const uint8_t* layerTable = getRange(header.LayerTableOffset, header.LayerCount, sizeof(LayerRecord));
+        const uint8_t* chunkTable = getRange(header.ChunkTableOffset, header.ChunkCount, sizeof(ChunkRecord));
+        layerStack.m_Layers.reserve(header.LayerCount);
+
+        // Chunks are decoded in parallel one batch at a time, then copied into their layer in table order
+        std::vector<std::array<uint16_t, TileChunk::TILE_COUNT>> batchTiles(std::min<size_t>(header.ChunkCount, CHUNK_BATCH_SIZE));
+        std::vector<ChunkRecord> batchRecords(batchTiles.size());
+        std::vector<const uint8_t*> batchBlocks(batchTiles.size());
+        std::vector<uint8_t> batchDecoded(batchTiles.size());
+
+        for (uint32_t layerIndex = 0; layerIndex < header.LayerCount; layerIndex++)
+        {
+            LayerRecord layerRecord;
+            std::memcpy(&layerRecord, layerTable + uint64_t(layerIndex) * sizeof(LayerRecord), sizeof(LayerRecord));
+            if (layerRecord.FirstChunk > header.ChunkCount || layerRecord.ChunkCount > header.ChunkCount - layerRecord.FirstChunk)
+                throw std::runtime_error("Layer chunks out of range");
+
+            TileLayer layer(header.Width, header.Height, palette);
+            layer.SetUnbounded(unbounded);
+            layer.SetName(getString(layerRecord.NameOffset, layerRecord.NameLength));
+            layer.SetVisibility((layerRecord.Flags & LAYER_VISIBLE) != 0);
+            layer.SetRenderGroup(static_cast<RenderGroup>(layerRecord.RenderGroup));
+
+            for (uint32_t batchStart = 0; batchStart < layerRecord.ChunkCount; batchStart += CHUNK_BATCH_SIZE)
+            {
+                const size_t batchCount = std::min<size_t>(CHUNK_BATCH_SIZE, layerRecord.ChunkCount - batchStart);
+                for (size_t i = 0; i < batchCount; i++)
+                {
+                    ChunkRecord& chunkRecord = batchRecords[i];
+                    std::memcpy(&chunkRecord, chunkTable + (uint64_t(layerRecord.FirstChunk) + batchStart + i) * sizeof(ChunkRecord), sizeof(ChunkRecord));
+                    // Chunks past these would put tile coordinates out of int32_t range
+                    constexpr int32_t chunkLimit = INT32_MAX / static_cast<int32_t>(TileChunk::SIZE) - 1;
+                    if (chunkRecord.ChunkX < -chunkLimit || chunkRecord.ChunkX > chunkLimit || chunkRecord.ChunkY < -chunkLimit || chunkRecord.ChunkY > chunkLimit)
+                        throw std::runtime_error("Chunk position out of range");
+
+                    batchBlocks[i] = getRange(chunkRecord.BlockOffset, chunkRecord.BlockSize, 1);
+                }
+
+                WorkerPool::Get().ParallelFor(batchCount, [&](size_t i)
+                    {
+                        std::array<uint16_t, TileChunk::TILE_COUNT>& tileIndices = batchTiles[i];
+                        batchDecoded[i] = DecodeChunk(batchRecords[i].Encoding, batchBlocks[i], batchRecords[i].BlockSize, tileIndices.data());
+
+                        // Indices past the palette would be read out of bounds later on, they become unpainted
+                        for (uint16_t& tileIndex : tileIndices)
+                        {
+                            tileIndex = tileIndex < paletteEntryCount ? tileIndex : TilePalette::DEFAULT_INDEX;
+                        }
+                    });
+
+                for (size_t i = 0; i < batchCount; i++)
+                {
+                    const ChunkRecord& chunkRecord = batchRecords[i];
+                    if (!batchDecoded[i])
+                        throw std::runtime_error("Invalid chunk block (encoding " + std::to_string(chunkRecord.Encoding) + ")");
+
+                    layer.SetChunkTiles(chunkRecord.ChunkX, chunkRecord.ChunkY, batchTiles[i].data());
+                }
+            }
+
+            layerStack.m_Layers.push_back(std::move(layer));
+        }
+
+        std::string projectName = getString(header.NameOffset, header.NameLength);
+        Ref<Project> project = CreateRef<Project>(layerStack.GetWidth(), layerStack.GetHeight(), projectName);
+        project->GetLayerStack() = std::move(layerStack);
+
+        if (header.AtlasCount > PackedTile::MAX_ATLAS_COUNT)
+            throw std::runtime_error("Too many texture atlases");
+
+        const uint8_t* atlasTable = getRange(header.AtlasTableOffset, header.AtlasCount, sizeof(AtlasRecord));
+        for (uint32_t atlasIndex = 0; atlasIndex < header.AtlasCount; atlasIndex++)
+        {
+            AtlasRecord atlasRecord;
+            std::memcpy(&atlasRecord, atlasTable + uint64_t(atlasIndex) * sizeof(AtlasRecord), sizeof(AtlasRecord));
+
+            std::string texturePath = getString(atlasRecord.PathOffset, atlasRecord.PathLength);
+            Ref<Lumina::TextureAtlas> atlas;
+            if (!texturePath.empty())
+            {
+                atlas = Lumina::TextureAtlas::Create(texturePath, atlasRecord.Width, atlasRecord.Height);
+                if (!atlas)
+                {
+                    LUMINA_LOG_INFO("ProjectFile::Load: Failed to create texture atlas from path: {}, keeping it without a texture", texturePath);
+                }
+            }
+
+            // Every atlas keeps its slot, later atlases would otherwise move under their tiles
+            if (!atlas)
+            {
+                atlas = Lumina::TextureAtlas::Create(atlasRecord.Width, atlasRecord.Height);
+            }
+            project->GetTextureAtlases().push_back(atlas);
+        }
+
+        LUMINA_LOG_INFO("ProjectFile::Load: Read {} layers, {} chunks and {} palette entries", header.LayerCount, header.ChunkCount, header.PaletteEntryCount);
+        return project;
+    }
+
+    bool ProjectFile::IsBinary(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        char magic[sizeof(MAGIC)] = {};
+        file.read(magic, sizeof(magic));
+        return file && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+    }
+
+    uint32_t ProjectFile::EncodeChunk(const TileChunk& chunk, const uint16_t* indexRemap, uint8_t* block, uint32_t& blockSize)
+    {
+        const uint16_t* tileIndices = chunk.GetTileIndices().GetData();
+
+        // Remapping keeps painted tiles painted, so the chunk row masks still describe the result
+        std::array<uint16_t, TileChunk::TILE_COUNT> remappedIndices;
+        if (indexRemap)
+        {
+            for (uint32_t i = 0; i < TileChunk::TILE_COUNT; i++)
+            {
+                remappedIndices[i] = indexRemap[tileIndices[i]];
+            }
+            tileIndices = remappedIndices.data();
+        }
+
+        uint32_t runCount = 1;
+        for (uint32_t i = 1; i < TileChunk::TILE_COUNT; i++)
+        {
+            runCount += tileIndices[i] != tileIndices[i - 1] ? 1 : 0;
+        }
+
+        const size_t rawSize = RAW_BLOCK_SIZE;
+        const size_t sparseSize = ROW_MASKS_SIZE + size_t(chunk.GetPaintedCount()) * sizeof(uint16_t);
+        const size_t runsSize = size_t(runCount) * 2 * sizeof(uint16_t);
+
+        // Encoded into scratch first, the block only receives it uncompressed when LZ does not help
+        std::array<uint8_t, RAW_BLOCK_SIZE> encoded;
+        size_t encodedSize = 0;
+        auto write = [&](const void* data, size_t size)
+            {
+                std::memcpy(encoded.data() + encodedSize, data, size);
+                encodedSize += size;
+            };
+
+        uint32_t encoding = ENCODING_RAW;
+        if (runsSize < sparseSize && runsSize < rawSize)
+        {
+            uint16_t run[2] = { 1, tileIndices[0] };
+            for (uint32_t i = 1; i < TileChunk::TILE_COUNT; i++)
+            {
+                if (tileIndices[i] == run[1])
+                {
+                    run[0]++;
+                    continue;
+                }
+
+                write(run, sizeof(run));
+                run[0] = 1;
+                run[1] = tileIndices[i];
+            }
+            write(run, sizeof(run));
+            encoding = ENCODING_RUNS;
+        }
+        else if (sparseSize < rawSize)
+        {
+            for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+            {
+                uint32_t mask = chunk.GetRowMask(localY);
+                write(&mask, sizeof(mask));
+            }
+
+            for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+            {
+                const uint16_t* row = tileIndices + localY * TileChunk::SIZE;
+                uint32_t mask = chunk.GetRowMask(localY);
+                while (mask != 0)
+                {
+                    write(&row[BitUtils::CountTrailingZeros(mask)], sizeof(uint16_t));
+                    mask &= mask - 1;
+                }
+            }
+            encoding = ENCODING_SPARSE;
+        }
+        else
+        {
+            write(tileIndices, rawSize);
+        }
+
+        // A capacity one below the encoded size makes Compress give up on anything that would not shrink
+        size_t compressedSize = LZ::Compress(encoded.data(), encodedSize, block, encodedSize - 1);
+        if (compressedSize != 0)
+        {
+            blockSize = static_cast<uint32_t>(compressedSize);
+            return encoding | ENCODING_LZ;
+        }
+
+        std::memcpy(block, encoded.data(), encodedSize);
+        blockSize = static_cast<uint32_t>(encodedSize);
+        return encoding;
+    }
+
+    bool ProjectFile::DecodeChunk(uint32_t encoding, const uint8_t* block, uint32_t blockSize, uint16_t* tileIndices)
+    {
+        // Decompressed into scratch, then decoded like any other block
+        std::array<uint8_t, MAX_DECOMPRESSED_SIZE> decompressed;
+        if ((encoding & ENCODING_LZ) != 0)
+        {
+            size_t decompressedSize = LZ::Decompress(block, blockSize, decompressed.data(), decompressed.size());
+            if (decompressedSize == SIZE_MAX)
+                return false;
+
+            encoding &= ~ENCODING_LZ;
+            block = decompressed.data();
+            blockSize = static_cast<uint32_t>(decompressedSize);
+        }
+
+        switch (encoding)
+        {
+        case ENCODING_RAW:
+        {
+            if (blockSize != RAW_BLOCK_SIZE)
+                return false;
+
+            std::memcpy(tileIndices, block, RAW_BLOCK_SIZE);
+            return true;
+        }
+
+        case ENCODING_SPARSE:
+        {
+            if (blockSize < ROW_MASKS_SIZE)
+                return false;
+
+            std::array<uint32_t, TileChunk::SIZE> rowMasks;
+            std::memcpy(rowMasks.data(), block, ROW_MASKS_SIZE);
+
+            size_t paintedCount = 0;
+            for (uint32_t mask : rowMasks)
+            {
+                paintedCount += BitUtils::PopCount(mask);
+            }
+            if (blockSize != ROW_MASKS_SIZE + paintedCount * sizeof(uint16_t))
+                return false;
+
+            std::fill_n(tileIndices, TileChunk::TILE_COUNT, TilePalette::DEFAULT_INDEX);
+            const uint8_t* painted = block + ROW_MASKS_SIZE;
+            for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+            {
+                uint32_t mask = rowMasks[localY];
+                while (mask != 0)
+                {
+                    uint32_t localX = BitUtils::CountTrailingZeros(mask);
+                    mask &= mask - 1;
+                    std::memcpy(&tileIndices[localY * TileChunk::SIZE + localX], painted, sizeof(uint16_t));
+                    painted += sizeof(uint16_t);
+                }
+            }
+            return true;
+        }
+
+        case ENCODING_RUNS:
+        {
+            if (blockSize % (2 * sizeof(uint16_t)) != 0)
+                return false;
+
+            uint32_t position = 0;
+            for (uint32_t offset = 0; offset < blockSize; offset += 2 * sizeof(uint16_t))
+            {
+                uint16_t run[2];
+                std::memcpy(run, block + offset, sizeof(run));
+                if (run[0] == 0 || run[0] > TileChunk::TILE_COUNT - position)
+                    return false;
+
+                std::fill_n(tileIndices + position, run[0], run[1]);
+                position += run[0];
+            }
+            return position == TileChunk::TILE_COUNT;
+        }
+
+        default:
+            return false;
+        }
+    }
+}
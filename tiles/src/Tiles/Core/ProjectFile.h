@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "Base.h"
+#include "Project.h"
+
+namespace Tiles
+{
+    // Binary .tiles project file. Everything is stored as fixed-size records at aligned offsets, so
+    // the loader maps the file and copies chunk blocks straight into layers without parsing tiles:
+    //
+    //   Header
+    //   PackedTile[PaletteEntryCount]      Palette entries 1 onward, entry 0 is always the default tile
+    //   LayerRecord[LayerCount]            Bottom to top
+    //   ChunkRecord[ChunkCount]            Grouped by layer, see LayerRecord::FirstChunk
+    //   AtlasRecord[AtlasCount]
+    //   String bytes                       Names and paths, referenced by offset and length
+    //   Chunk blocks                       Back to back, each in the smallest of the encodings below
+    //
+    // Chunk block encodings, all of them in row-major tile order:
+    //
+    //   ENCODING_RAW       TileChunk::TILE_COUNT palette indices
+    //   ENCODING_SPARSE    TileChunk::SIZE row masks of painted tiles (uint32_t), then one index per painted tile
+    //   ENCODING_RUNS      (uint16_t length, uint16_t index) pairs covering every tile of the chunk
+    //
+    // Chunks are only stored where a layer has painted tiles, sparse blocks leave out the unpainted
+    // tiles inside them and run blocks collapse fills. On top of that, ENCODING_LZ marks blocks that
+    // were compressed with LZ (see LZ.h) after encoding, which only happens when it makes them
+    // smaller and mostly catches repeating patterns the encodings above store tile by tile. Chunks
+    // are encoded and decoded in parallel on the WorkerPool.
+    //
+    // Palette entries no layer uses are left out and the remaining ones renumbered, so the palette
+    // of a project does not keep growing across sessions.
+    //
+    // Version 1 files only hold raw blocks, version 2 files hold no compressed blocks.
+    //
+    // Integers are little endian. Projects saved before this format are JSON (see Project::WriteJSON)
+    // and still load, JSON also stays available as an export.
+    class ProjectFile
+    {
+    public:
+        static constexpr uint32_t VERSION = 3;
+
+        // Writes a temporary file next to path and moves it over path once complete, so a failed
+        // save leaves the previous file intact. Returns the number of unused palette entries left
+        // out of the file, see EditJournal::Start. Throws std::runtime_error on failure.
+        static size_t Save(const Project& project, const std::filesystem::path& path);
+
+        // Throws std::runtime_error when the file is not a valid binary project
+        static Ref<Project> Load(const std::filesystem::path& path);
+
+        // Whether the file starts with the binary project signature
+        static bool IsBinary(const std::filesystem::path& path);
+
+    private:
+        struct Header
+        {
+            char Magic[8];                          // "TILESBIN"
+            uint32_t Version;
+            uint32_t Flags;                         // FLAG_UNBOUNDED
+            uint32_t Width;                         // Layer stack size, unused when unbounded
+            uint32_t Height;
+            uint32_t NameOffset;                    // Project name in the string bytes
+            uint32_t NameLength;
+            uint32_t PaletteEntryCount;
+            uint32_t LayerCount;
+            uint32_t ChunkCount;
+            uint32_t AtlasCount;
+            uint64_t PaletteOffset;
+            uint64_t LayerTableOffset;
+            uint64_t ChunkTableOffset;
+            uint64_t AtlasTableOffset;
+            uint64_t StringsOffset;
+            uint64_t StringsSize;
+            uint64_t ChunkBlocksOffset;
+            uint64_t FileSize;                      // Catches truncated files
+        };
+
+        struct LayerRecord
+        {
+            uint32_t NameOffset;
+            uint32_t NameLength;
+            int32_t RenderGroup;
+            uint32_t Flags;                         // LAYER_VISIBLE
+            uint32_t FirstChunk;                    // Index into the chunk table
+            uint32_t ChunkCount;
+        };
+
+        struct ChunkRecord
+        {
+            int32_t ChunkX;
+            int32_t ChunkY;
+            uint64_t BlockOffset;                   // From the start of the file
+            uint32_t BlockSize;
+            uint32_t Encoding;                      // ENCODING_RAW, ENCODING_SPARSE or ENCODING_RUNS, optionally with ENCODING_LZ
+        };
+
+        struct AtlasRecord
+        {
+            uint32_t PathOffset;
+            uint32_t PathLength;                    // 0 for an atlas without a texture
+            uint32_t Width;
+            uint32_t Height;
+        };
+
+        static constexpr uint32_t FLAG_UNBOUNDED = 1 << 0;
+        static constexpr uint32_t LAYER_VISIBLE = 1 << 0;
+        static constexpr uint32_t ENCODING_RAW = 0;
+        static constexpr uint32_t ENCODING_SPARSE = 1;
+        static constexpr uint32_t ENCODING_RUNS = 2;
+        static constexpr uint32_t ENCODING_LZ = 1 << 8;   // Flag, the encoded block is LZ compressed
+
+        // Writes the chunk in its smallest encoding to block, which must hold TileChunk::TILE_COUNT
+        // indices, and returns the encoding. Indices go through indexRemap unless it is null. Safe to
+        // call from several threads at once.
+        static uint32_t EncodeChunk(const TileChunk& chunk, const uint16_t* indexRemap, uint8_t* block, uint32_t& blockSize);
+
+        // False when the block is malformed. Safe to call from several threads at once.
+        static bool DecodeChunk(uint32_t encoding, const uint8_t* block, uint32_t blockSize, uint16_t* tileIndices);
+    };
+}
@@ -0,0 +1,508 @@
+#include "ProjectJSONReader.h"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <stdexcept>
+
+#include "Lumina/Core/Log.h"
+
+#include "Constants.h"
+
+namespace Tiles
+{
+    // Size and boundedness are only known once the layer stack has been read, the project starts
+    // unbounded so no layer clips tiles before then
+    ProjectJSONReader::ProjectJSONReader()
+        : m_Project(CreateRef<Project>(0, 0, "Loaded Project", true)), m_LayerStack(m_Project->GetLayerStack())
+    {
+        m_Scopes.push_back(Scope::Root);
+    }
+
+    Ref<Project> ProjectJSONReader::Load(std::istream& stream)
+    {
+        LUMINA_LOG_INFO("ProjectJSONReader::Load: Loading project from JSON");
+
+        ProjectJSONReader reader;
+        if (!nlohmann::json::sax_parse(stream, &reader))
+            throw std::runtime_error(reader.m_Error.empty() ? std::string("Invalid JSON") : reader.m_Error);
+
+        if (!reader.m_HasProject)
+            throw std::runtime_error("JSON missing required LayerStack field");
+
+        Ref<Project> project = reader.m_Project;
+
+        size_t loadedCount = 0;
+        for (const AtlasInfo& atlasInfo : reader.m_Atlases)
+        {
+            if (!project->CanAddTextureAtlas())
+            {
+                LUMINA_LOG_INFO("ProjectJSONReader::Load: Skipping atlas '{}', projects hold at most {} texture atlases", atlasInfo.Path, PackedTile::MAX_ATLAS_COUNT);
+                continue;
+            }
+
+            if (atlasInfo.Width == 0 || atlasInfo.Height == 0)
+            {
+                LUMINA_LOG_INFO("ProjectJSONReader::Load: Skipping invalid atlas entry: path='{}', width={}, height={}", atlasInfo.Path, atlasInfo.Width, atlasInfo.Height);
+                continue;
+            }
+
+            // An empty path is an atlas without a texture, it still holds its slot for the tiles after it
+            Ref<Lumina::TextureAtlas> atlas;
+            if (!atlasInfo.Path.empty())
+            {
+                atlas = Lumina::TextureAtlas::Create(atlasInfo.Path, atlasInfo.Width, atlasInfo.Height);
+                if (!atlas)
+                {
+                    LUMINA_LOG_INFO("ProjectJSONReader::Load: Failed to create texture atlas from path: {}, keeping it without a texture", atlasInfo.Path);
+                }
+            }
+
+            if (!atlas)
+            {
+                atlas = Lumina::TextureAtlas::Create(atlasInfo.Width, atlasInfo.Height);
+            }
+            else
+            {
+                loadedCount++;
+            }
+            project->GetTextureAtlases().push_back(atlas);
+        }
+
+        LUMINA_LOG_INFO("ProjectJSONReader::Load: Project '{}' loaded with {} layers and {} texture atlases (attempted {})",
+            project->GetProjectName(), project->GetLayerStack().GetLayerCount(), loadedCount, reader.m_Atlases.size());
+        return project;
+    }
+
+    bool ProjectJSONReader::null()
+    {
+        return Value({});
+    }
+
+    bool ProjectJSONReader::boolean(bool value)
+    {
+        switch (m_Scopes.back())
+        {
+        case Scope::LayerStack:
+            if (m_Key == JSON::LayerStack::Unbounded)
+                m_Unbounded = value;
+            return true;
+
+        case Scope::Layer:
+            if (m_Key == JSON::TileLayer::Visible)
+                m_LayerStack.m_Layers.back().SetVisibility(value);
+            return true;
+
+        case Scope::Tile:
+            if (m_Key == JSON::Tile::Painted)
+                m_Tile.SetPainted(value);
+            else if (m_Key == JSON::Tile::Textured)
+                m_Tile.SetTextured(value);
+            return true;
+
+        default:
+            return Value({});
+        }
+    }
+
+    bool ProjectJSONReader::number_integer(int64_t value)
+    {
+        Number number;
+        number.Value = static_cast<double>(value);
+        number.IsUnsigned = value >= 0;
+        number.UnsignedValue = value >= 0 ? static_cast<uint64_t>(value) : 0;
+        return Value(number);
+    }
+
+    bool ProjectJSONReader::number_unsigned(uint64_t value)
+    {
+        Number number;
+        number.Value = static_cast<double>(value);
+        number.IsUnsigned = true;
+        number.UnsignedValue = value;
+        return Value(number);
+    }
+
+    bool ProjectJSONReader::number_float(double value, const std::string& text)
+    {
+        Number number;
+        number.Value = value;
+        return Value(number);
+    }
+
+    bool ProjectJSONReader::string(std::string& value)
+    {
+        switch (m_Scopes.back())
+        {
+        case Scope::Project:
+            if (m_Key == JSON::Project::Name)
+                m_Project->SetProjectName(value);
+            return true;
+
+        case Scope::Layer:
+            if (m_Key == JSON::TileLayer::Name)
+                m_LayerStack.m_Layers.back().SetName(value);
+            return true;
+
+        case Scope::Atlas:
+            if (m_Key == JSON::Atlas::Path)
+                m_Atlases.back().Path = std::move(value);
+            return true;
+
+        default:
+            return Value({});
+        }
+    }
+
+    bool ProjectJSONReader::binary(std::vector<uint8_t>& value)
+    {
+        return Value({});
+    }
+
+    bool ProjectJSONReader::start_object(size_t elementCount)
+    {
+        Scope scope = m_Scopes.back();
+
+        if (scope == Scope::Root)
+        {
+            Open(Scope::Project);
+        }
+        else if (scope == Scope::Project && m_Key == JSON::Project::LayerStack)
+        {
+            m_HasProject = true;
+            Open(Scope::LayerStack);
+        }
+        else if (scope == Scope::Atlases)
+        {
+            m_Atlases.emplace_back();
+            Open(Scope::Atlas);
+        }
+        else if (scope == Scope::Layers)
+        {
+            TileLayer& layer = m_LayerStack.m_Layers.emplace_back(0, 0, m_LayerStack.m_Palette);
+            layer.SetUnbounded(true);
+            m_LayerInfos.emplace_back();
+            m_OriginX = 0;
+            m_OriginY = 0;
+            Open(Scope::Layer);
+        }
+        else if (scope == Scope::Palette || scope == Scope::TileRow)
+        {
+            m_Tile = Tile();
+            Open(Scope::Tile);
+        }
+        else
+        {
+            // Cells of index rows are numbers, anything else there still takes up its cell
+            if (scope == Scope::TileIndexRow)
+                Value({});
+            Open(Scope::Ignored);
+        }
+
+        return true;
+    }
+
+    bool ProjectJSONReader::key(std::string& value)
+    {
+        m_Key = std::move(value);
+        return true;
+    }
+
+    bool ProjectJSONReader::end_object()
+    {
+        Scope scope = m_Scopes.back();
+        m_Scopes.pop_back();
+        m_Key.clear();
+
+        if (scope == Scope::Tile)
+            EndTile();
+        else if (scope == Scope::LayerStack)
+            EndLayerStack();
+
+        return true;
+    }
+
+    bool ProjectJSONReader::start_array(size_t elementCount)
+    {
+        Scope scope = m_Scopes.back();
+
+        if (scope == Scope::Project && m_Key == JSON::Atlas::Array)
+        {
+            Open(Scope::Atlases);
+        }
+        else if (scope == Scope::LayerStack && m_Key == JSON::LayerStack::Palette)
+        {
+            Open(Scope::Palette);
+        }
+        else if (scope == Scope::LayerStack && m_Key == JSON::LayerStack::TileLayers)
+        {
+            Open(Scope::Layers);
+        }
+        else if (scope == Scope::Layer && m_Key == JSON::TileLayer::TileRuns)
+        {
+            m_RunSize = 0;
+            Open(Scope::TileRuns);
+        }
+        else if (scope == Scope::Layer && (m_Key == JSON::TileLayer::TileIndices || m_Key == JSON::TileLayer::Tiles))
+        {
+            m_RowY = 0;
+            Open(m_Key == JSON::TileLayer::TileIndices ? Scope::TileIndexRows : Scope::TileRows);
+        }
+        else if (scope == Scope::TileIndexRows || scope == Scope::TileRows)
+        {
+            m_Row.clear();
+            Open(scope == Scope::TileIndexRows ? Scope::TileIndexRow : Scope::TileRow);
+        }
+        else if (scope == Scope::Tile && (m_Key == JSON::Tile::Rotation || m_Key == JSON::Tile::Size ||
+            m_Key == JSON::Tile::TextureCoords || m_Key == JSON::Tile::TintColor))
+        {
+            m_TileVectorKey = m_Key;
+            m_TileVectorSize = 0;
+            Open(Scope::TileVector);
+        }
+        else
+        {
+            if (scope == Scope::TileIndexRow || scope == Scope::TileRow)
+                Value({});
+            Open(Scope::Ignored);
+        }
+
+        return true;
+    }
+
+    bool ProjectJSONReader::end_array()
+    {
+        Scope scope = m_Scopes.back();
+        m_Scopes.pop_back();
+        m_Key.clear();
+
+        if (scope == Scope::TileIndexRow || scope == Scope::TileRow)
+        {
+            EndTileRow();
+        }
+        else if (scope == Scope::TileVector)
+        {
+            const float* v = m_TileVector;
+            if (m_TileVectorKey == JSON::Tile::Rotation && m_TileVectorSize >= 3)
+                m_Tile.SetRotation({ v[0], v[1], v[2] });
+            else if (m_TileVectorKey == JSON::Tile::Size && m_TileVectorSize >= 2)
+                m_Tile.SetSize({ v[0], v[1] });
+            else if (m_TileVectorKey == JSON::Tile::TextureCoords && m_TileVectorSize >= 4)
+                m_Tile.SetTextureCoords({ v[0], v[1], v[2], v[3] });
+            else if (m_TileVectorKey == JSON::Tile::TintColor && m_TileVectorSize >= 4)
+                m_Tile.SetTint({ v[0], v[1], v[2], v[3] });
+        }
+
+        return true;
+    }
+
+    bool ProjectJSONReader::parse_error(size_t position, const std::string& lastToken, const nlohmann::detail::exception& exception)
+    {
+        m_Error = exception.what();
+        return false;
+    }
+
+    bool ProjectJSONReader::Value(const Number& number)
+    {
+        switch (m_Scopes.back())
+        {
+        case Scope::TileIndexRow:
+            // Indices are checked against the palette once the whole stack is read
+            if (number.IsUnsigned && number.UnsignedValue < TilePalette::MAX_ENTRY_COUNT)
+            {
+                m_Row.push_back(static_cast<uint16_t>(number.UnsignedValue));
+            }
+            else
+            {
+                m_Row.push_back(TilePalette::DEFAULT_INDEX);
+                m_InvalidIndexCount++;
+            }
+            break;
+
+        case Scope::TileRow:
+            m_Row.push_back(TilePalette::DEFAULT_INDEX);
+            break;
+
+        case Scope::TileRuns:
+            m_Run[m_RunSize++] = number.IsUnsigned ? static_cast<int64_t>(std::min<uint64_t>(number.UnsignedValue, INT64_MAX)) :
+                static_cast<int64_t>(std::clamp(number.Value, static_cast<double>(INT32_MIN), static_cast<double>(INT32_MAX)));
+            if (m_RunSize == std::size(m_Run))
+            {
+                EndTileRun();
+                m_RunSize = 0;
+            }
+            break;
+
+        case Scope::TileVector:
+            if (m_TileVectorSize < std::size(m_TileVector))
+                m_TileVector[m_TileVectorSize] = static_cast<float>(number.Value);
+            m_TileVectorSize++;
+            break;
+
+        case Scope::Tile:
+            if (m_Key == JSON::Tile::AtlasIndex)
+                m_Tile.SetAtlasIndex(number.IsUnsigned ? static_cast<size_t>(number.UnsignedValue) : Tile::INVALID_ATLAS_INDEX);
+            break;
+
+        case Scope::Layer:
+            if (m_Key == JSON::TileLayer::Width)
+                m_LayerInfos.back().Width = ToUInt32(number);
+            else if (m_Key == JSON::TileLayer::Height)
+                m_LayerInfos.back().Height = ToUInt32(number);
+            else if (m_Key == JSON::TileLayer::OriginX)
+                m_OriginX = ToInt32(number);
+            else if (m_Key == JSON::TileLayer::OriginY)
+                m_OriginY = ToInt32(number);
+            else if (m_Key == JSON::TileLayer::RenderGroup)
+                m_LayerStack.m_Layers.back().SetRenderGroup(static_cast<RenderGroup>(ToInt32(number)));
+            break;
+
+        case Scope::LayerStack:
+            if (m_Key == JSON::LayerStack::Width)
+                m_Width = ToUInt32(number);
+            else if (m_Key == JSON::LayerStack::Height)
+                m_Height = ToUInt32(number);
+            break;
+
+        case Scope::Atlas:
+            if (m_Key == JSON::Atlas::Width)
+                m_Atlases.back().Width = ToUInt32(number);
+            else if (m_Key == JSON::Atlas::Height)
+                m_Atlases.back().Height = ToUInt32(number);
+            break;
+
+        default:
+            break;
+        }
+
+        return true;
+    }
+
+    void ProjectJSONReader::EndTile()
+    {
+        TilePalette& palette = *m_LayerStack.m_Palette;
+
+        if (m_Scopes.back() == Scope::TileRow)
+        {
+            // Tiles past a full palette are left unpainted, the same as unusable indices
+            uint16_t tileIndex = TilePalette::DEFAULT_INDEX;
+            if (!palette.Intern(m_Tile, tileIndex))
+                m_InvalidIndexCount++;
+
+            m_Row.push_back(tileIndex);
+            return;
+        }
+
+        // Append rather than intern so saved indices keep their meaning even if two entries collide
+        if (palette.GetEntryCount() < TilePalette::MAX_ENTRY_COUNT)
+            palette.Append(PackedTile::FromTile(m_Tile));
+        else if (palette.GetEntryCount() == TilePalette::MAX_ENTRY_COUNT)
+            LUMINA_LOG_INFO("ProjectJSONReader::EndTile: Palette has more than {} entries, ignoring the rest", TilePalette::MAX_ENTRY_COUNT);
+    }
+
+    void ProjectJSONReader::EndTileRow()
+    {
+        // The row buffer is reused, it only ever holds one row of one layer
+        TileLayer& layer = m_LayerStack.m_Layers.back();
+        layer.SetRowTiles(m_OriginX, m_OriginY + m_RowY, static_cast<uint32_t>(m_Row.size()), m_Row.data());
+        m_RowY++;
+    }
+
+    void ProjectJSONReader::EndTileRun()
+    {
+        const int64_t x = m_Run[0];
+        const int64_t y = m_Run[1];
+        const int64_t length = m_Run[2];
+        const int64_t index = m_Run[3];
+
+        // Runs that can't be placed are dropped, like rows that don't fit a layer
+        if (x < INT32_MIN || y < INT32_MIN || y > INT32_MAX || length <= 0 || length > int64_t(INT32_MAX) - x)
+            return;
+
+        uint16_t tileIndex = TilePalette::DEFAULT_INDEX;
+        if (index >= 0 && index < int64_t(TilePalette::MAX_ENTRY_COUNT))
+            tileIndex = static_cast<uint16_t>(index);
+        else
+            m_InvalidIndexCount += static_cast<size_t>(length);
+
+        // Written one chunk span at a time, so a run takes no memory beyond its chunks
+        std::array<uint16_t, TileChunk::SIZE> span;
+        span.fill(tileIndex);
+
+        TileLayer& layer = m_LayerStack.m_Layers.back();
+        for (int64_t offset = 0; offset < length;)
+        {
+            int32_t spanX = static_cast<int32_t>(x + offset);
+            uint32_t spanLength = static_cast<uint32_t>(std::min<int64_t>(TileChunk::SIZE - TileChunk::GetLocalCoord(spanX), length - offset));
+            layer.SetRowTiles(spanX, static_cast<int32_t>(y), spanLength, span.data());
+            offset += spanLength;
+        }
+    }
+
+    void ProjectJSONReader::EndLayerStack()
+    {
+        const size_t paletteEntryCount = m_LayerStack.m_Palette->GetEntryCount();
+
+        for (size_t i = 0; i < m_LayerStack.m_Layers.size(); i++)
+        {
+            TileLayer& layer = m_LayerStack.m_Layers[i];
+
+            // Indices past the palette would be read out of bounds later on, they become unpainted.
+            // Only chunks that hold one are rewritten.
+            std::vector<std::pair<int32_t, int32_t>> invalidChunks;
+            layer.ForEachChunk([&](int32_t chunkX, int32_t chunkY, const TileChunk& chunk)
+                {
+                    ColumnSpan<const uint16_t> tileIndices = chunk.GetTileIndices();
+                    if (*std::max_element(tileIndices.begin(), tileIndices.end()) >= paletteEntryCount)
+                        invalidChunks.emplace_back(chunkX, chunkY);
+                });
+
+            std::array<uint16_t, TileChunk::TILE_COUNT> tileIndices;
+            for (const auto& [chunkX, chunkY] : invalidChunks)
+            {
+                ColumnSpan<const uint16_t> source = layer.GetChunk(chunkX, chunkY)->GetTileIndices();
+                for (size_t j = 0; j < tileIndices.size(); j++)
+                {
+                    bool isValid = source[j] < paletteEntryCount;
+                    tileIndices[j] = isValid ? source[j] : TilePalette::DEFAULT_INDEX;
+                    m_InvalidIndexCount += isValid ? 0 : 1;
+                }
+                layer.SetChunkTiles(chunkX, chunkY, tileIndices.data());
+            }
+
+            // Layers keep the tiles inside their own saved size, then take the size of the stack
+            if (!m_Unbounded)
+            {
+                const LayerInfo& layerInfo = m_LayerInfos[i];
+                layer.SetBounded(std::min(layerInfo.Width, m_Width), std::min(layerInfo.Height, m_Height));
+                layer.Resize(m_Width, m_Height);
+            }
+        }
+
+        if (m_InvalidIndexCount > 0)
+        {
+            LUMINA_LOG_INFO("ProjectJSONReader::EndLayerStack: {} tiles had an unusable palette index or did not fit the palette, using default tile", m_InvalidIndexCount);
+        }
+
+        m_LayerStack.m_Width = m_Width;
+        m_LayerStack.m_Height = m_Height;
+        m_LayerStack.m_Unbounded = m_Unbounded;
+        m_LayerStack.TouchStructure();
+    }
+
+    uint32_t ProjectJSONReader::ToUInt32(const Number& number)
+    {
+        if (number.IsUnsigned)
+            return static_cast<uint32_t>(std::min<uint64_t>(number.UnsignedValue, UINT32_MAX));
+
+        return static_cast<uint32_t>(std::clamp(number.Value, 0.0, static_cast<double>(UINT32_MAX)));
+    }
+
+    int32_t ProjectJSONReader::ToInt32(const Number& number)
+    {
+        if (number.IsUnsigned)
+            return static_cast<int32_t>(std::min<uint64_t>(number.UnsignedValue, INT32_MAX));
+
+        return static_cast<int32_t>(std::clamp(number.Value, static_cast<double>(INT32_MIN), static_cast<double>(INT32_MAX)));
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "Base.h"
+#include "Project.h"
+
+namespace Tiles
+{
+    // Loads JSON projects (saved before the binary format, or exported) through nlohmann's SAX
+    // interface. Tile rows are decoded straight into the layers of the project being built, so no
+    // document tree or layer copies exist at any point and peak memory stays close to the loaded
+    // project.
+    //
+    // Keys can come in any order. Files written through nlohmann::json have sorted keys, which puts
+    // a stack's layers before its palette and size, so layers are filled unbounded while streaming
+    // and only bounded and checked against the palette once the layer stack is complete.
+    class ProjectJSONReader
+    {
+    public:
+        // Throws std::runtime_error when the stream is not a valid JSON project
+        static Ref<Project> Load(std::istream& stream);
+
+        // nlohmann::json SAX interface, returning false stops the parse
+        bool null();
+        bool boolean(bool value);
+        bool number_integer(int64_t value);
+        bool number_unsigned(uint64_t value);
+        bool number_float(double value, const std::string& text);
+        bool string(std::string& value);
+        bool binary(std::vector<uint8_t>& value);
+        bool start_object(size_t elementCount);
+        bool key(std::string& value);
+        bool end_object();
+        bool start_array(size_t elementCount);
+        bool end_array();
+        bool parse_error(size_t position, const std::string& lastToken, const nlohmann::detail::exception& exception);
+
+    private:
+        // What the innermost open object or array holds
+        enum class Scope : uint8_t
+        {
+            Root,
+            Project,
+            Atlases,
+            Atlas,
+            LayerStack,
+            Palette,
+            Layers,
+            Layer,
+            TileIndexRows,
+            TileIndexRow,
+            TileRuns,                                   // Flat x, y, length, index groups
+            TileRows,                                   // Projects saved before the palette store full tiles per cell
+            TileRow,
+            Tile,
+            TileVector,                                 // Rotation, size, texture coords or tint of a tile
+            Ignored                                     // Unknown keys, skipped with everything inside
+        };
+
+        struct Number
+        {
+            double Value = 0.0;
+            bool IsUnsigned = false;                    // Non-negative integer, exact in UnsignedValue
+            uint64_t UnsignedValue = 0;
+        };
+
+        struct LayerInfo
+        {
+            uint32_t Width = 0;
+            uint32_t Height = 0;
+        };
+
+        struct AtlasInfo
+        {
+            std::string Path;
+            uint32_t Width = 0;
+            uint32_t Height = 0;
+        };
+
+        ProjectJSONReader();
+
+        void Open(Scope scope) { m_Scopes.push_back(scope); m_Key.clear(); }
+        bool Value(const Number& number);
+        void EndTile();
+        void EndTileRow();
+        void EndTileRun();
+        void EndLayerStack();
+
+        static uint32_t ToUInt32(const Number& number);
+        static int32_t ToInt32(const Number& number);
+
+    private:
+        Ref<Project> m_Project;
+        LayerStack& m_LayerStack;
+
+        std::vector<Scope> m_Scopes;                    // Open containers, innermost last
+        std::string m_Key;                              // Key of the value about to be read
+        std::string m_TileVectorKey;                    // Key of the open TileVector
+        std::string m_Error;
+
+        bool m_HasProject = false;                      // Whether the root object had a layer stack
+        bool m_Unbounded = false;                       // Layer stack fields, applied once the stack ends
+        uint32_t m_Width = 0;
+        uint32_t m_Height = 0;
+
+        std::vector<LayerInfo> m_LayerInfos;            // Per layer size, in m_LayerStack order
+        int32_t m_OriginX = 0;                          // Origin of the open layer
+        int32_t m_OriginY = 0;
+        int32_t m_RowY = 0;                             // Row of the open layer being read
+        std::vector<uint16_t> m_Row;                    // Indices of the row being read
+        int64_t m_Run[4] = {};                          // Run being read, see JSON::TileLayer::TileRuns
+        size_t m_RunSize = 0;
+        size_t m_InvalidIndexCount = 0;                 // Tiles reset because their index was unusable
+
+        Tile m_Tile;                                    // Tile object being read
+        float m_TileVector[4] = {};
+        size_t m_TileVectorSize = 0;
+
+        std::vector<AtlasInfo> m_Atlases;
+    };
+}
@@ -0,0 +1,135 @@
+#include "SpillFile.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "Lumina/Core/Log.h"
+
+namespace Tiles
+{
+    SpillFile::~SpillFile()
+    {
+        Close();
+    }
+
+    bool SpillFile::Write(const std::vector<uint8_t>& bytes, uint64_t& offset)
+    {
+        if (!m_File.is_open() && !Open())
+            return false;
+
+        m_File.seekp(static_cast<std::streamoff>(m_Size));
+        m_File.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!m_File)
+        {
+            LUMINA_LOG_INFO("SpillFile::Write: Failed to write {} bytes to '{}'", bytes.size(), m_Path.string());
+            m_File.clear();
+            return false;
+        }
+
+        offset = m_Size;
+        m_Size += bytes.size();
+        return true;
+    }
+
+    std::vector<uint8_t> SpillFile::Read(uint64_t offset, size_t size)
+    {
+        if (!m_File.is_open() || offset + size > m_Size)
+            throw std::runtime_error("SpillFile::Read: Range is not part of the file");
+
+        std::vector<uint8_t> bytes(size);
+        m_File.seekg(static_cast<std::streamoff>(offset));
+        m_File.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(size));
+        if (!m_File)
+        {
+            m_File.clear();
+            throw std::runtime_error("SpillFile::Read: Failed to read from '" + m_Path.string() + "'");
+        }
+
+        return bytes;
+    }
+
+    void SpillFile::Reset()
+    {
+        if (m_Size == 0)
+            return;
+
+        // Reopening with trunc drops the contents but keeps the same path
+        m_File.close();
+        m_File.open(m_Path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        m_Size = 0;
+
+        // Removes the old file, the next write then creates a new one
+        if (!m_File.is_open())
+            Close();
+    }
+
+    void SpillFile::Compact(const std::vector<std::pair<uint64_t*, size_t>>& blocks)
+    {
+        std::vector<std::pair<uint64_t*, size_t>> ordered = blocks;
+        std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) { return *a.first < *b.first; });
+
+        // Blocks only ever move towards the front, so each one is read before anything overwrites it
+        uint64_t end = 0;
+        for (auto& [offset, size] : ordered)
+        {
+            if (*offset != end)
+            {
+                std::vector<uint8_t> bytes = Read(*offset, size);
+                m_File.seekp(static_cast<std::streamoff>(end));
+                m_File.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(size));
+                if (!m_File)
+                {
+                    m_File.clear();
+                    throw std::runtime_error("SpillFile::Compact: Failed to write to '" + m_Path.string() + "'");
+                }
+                *offset = end;
+            }
+            end += size;
+        }
+
+        // The file keeps its length on disk, later writes reuse the space past the new end
+        m_Size = end;
+    }
+
+    bool SpillFile::Open()
+    {
+        if (m_Failed)
+            return false;
+
+        std::error_code error;
+        std::filesystem::path directory = std::filesystem::temp_directory_path(error);
+        if (!error)
+        {
+            // Several editor instances may spill at the same time
+            std::random_device random;
+            m_Path = directory / ("tiles-spill-" + std::to_string(random()) + std::to_string(random()) + ".bin");
+            m_File.open(m_Path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        }
+
+        if (!m_File.is_open())
+        {
+            LUMINA_LOG_INFO("SpillFile::Open: Could not create a spill file, data stays in memory");
+            m_Failed = true;
+            m_Path.clear();
+            return false;
+        }
+
+        m_Size = 0;
+        return true;
+    }
+
+    void SpillFile::Close()
+    {
+        if (m_Path.empty())
+            return;
+
+        m_File.close();
+
+        std::error_code error;
+        std::filesystem::remove(m_Path, error);
+        m_Path.clear();
+        m_Size = 0;
+    }
+}
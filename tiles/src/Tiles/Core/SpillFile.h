@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace Tiles
+{
+    // Scratch file in the system temp directory for data pushed out of memory. The file is created on
+    // the first write and removed on destruction. Writes always append, space is reclaimed by Compact,
+    // which packs the blocks still needed at the front so later writes reuse the rest, or by Reset
+    // once nothing in the file is needed anymore.
+    class SpillFile
+    {
+    public:
+        SpillFile() = default;
+        ~SpillFile();
+
+        SpillFile(const SpillFile&) = delete;
+        SpillFile& operator=(const SpillFile&) = delete;
+
+        // Appends bytes and returns their offset through offset, false when the file can't be written
+        bool Write(const std::vector<uint8_t>& bytes, uint64_t& offset);
+
+        // Reads back what Write stored at offset, throws std::runtime_error on failure
+        std::vector<uint8_t> Read(uint64_t offset, size_t size);
+
+        // Empties the file, offsets from earlier writes become invalid
+        void Reset();
+
+        // Moves the given blocks (offset, size) to the front of the file, one after another in file
+        // order, and updates their offsets. Everything else is dropped. Throws std::runtime_error
+        // when a block can't be moved.
+        void Compact(const std::vector<std::pair<uint64_t*, size_t>>& blocks);
+
+        uint64_t GetSize() const { return m_Size; }
+
+    private:
+        bool Open();
+        void Close();
+
+    private:
+        std::filesystem::path m_Path;               // Empty until the file is created
+        std::fstream m_File;                        // Open for reading and writing once created
+        uint64_t m_Size = 0;                        // Bytes written since the last reset
+        bool m_Failed = false;                      // Set when the file could not be created
+    };
+}
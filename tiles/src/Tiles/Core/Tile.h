@@ -1,10 +1,14 @@
 #pragma once
 
+#include <functional>
+
 #include "glm/glm.hpp"
 
 // This is wrong we need nlohmann in the dependencies. 
 #include "json.hpp"
 
+#include "JsonWriter.h"
+
 namespace Tiles
 {
 	class Tile
@@ -40,13 +44,14 @@ namespace Tiles
 		void SetTint(const glm::vec4& tint) { TintColor = tint; }
 		void SetTextureCoords(const glm::vec4& textureCoords) { m_TextureCoords = textureCoords; }
 
+		// Tiles compare and hash through their canonical PackedTile form: rotations snap to quarter
+		// turns and flips, tint and texture coords are quantized, and all unpainted tiles are equal.
 		bool operator==(const Tile& other) const;
 		bool operator!=(const Tile& other) const;
 
 		static constexpr size_t INVALID_ATLAS_INDEX = SIZE_MAX;
 
-		nlohmann::json ToJSON() const;
-		static Tile FromJSON(const nlohmann::json& j);
+		void WriteJSON(JsonWriter& writer) const;
 
 	private:
 		bool m_IsPainted = false;
@@ -58,4 +63,13 @@ namespace Tiles
 		size_t m_AtlasIndex = INVALID_ATLAS_INDEX;
 		glm::vec4 m_TextureCoords = { 0, 0, 1, 1 };
 	};
+}
+
+namespace std
+{
+	template<>
+	struct hash<Tiles::Tile>
+	{
+		size_t operator()(const Tiles::Tile& tile) const;
+	};
 }
\ No newline at end of file
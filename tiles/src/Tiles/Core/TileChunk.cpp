@@ -0,0 +1,151 @@
+#include "TileChunk.h"
+
+#include <algorithm>
+
+#include "BitUtils.h"
+
+#include "Lumina/Core/Assert.h"
+
+namespace Tiles
+{
+    int32_t TileChunk::SetTileIndex(uint32_t localX, uint32_t localY, uint16_t tileIndex)
+    {
+        LUMINA_ASSERT(localX < SIZE && localY < SIZE, "TileChunk::SetTileIndex: Local position out of bounds");
+
+        m_TileIndices[GetLocalIndex(localX, localY)] = tileIndex;
+
+        uint32_t bit = 1u << localX;
+        bool wasPainted = (m_RowMasks[localY] & bit) != 0;
+        bool isPainted = tileIndex != TilePalette::DEFAULT_INDEX;
+
+        if (!wasPainted && isPainted)
+        {
+            m_RowMasks[localY] |= bit;
+            m_PaintedCount++;
+            return 1;
+        }
+
+        if (wasPainted && !isPainted)
+        {
+            m_RowMasks[localY] &= ~bit;
+            m_PaintedCount--;
+            return -1;
+        }
+
+        return 0;
+    }
+
+    int32_t TileChunk::WriteRow(uint32_t localX, uint32_t localY, const uint16_t* tileIndices, uint32_t count, const uint8_t* mask)
+    {
+        LUMINA_ASSERT(localX + count <= SIZE && localY < SIZE, "TileChunk::WriteRow: Row segment out of bounds");
+
+        uint16_t* row = m_TileIndices.data() + GetLocalIndex(localX, localY);
+        if (mask)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (mask[i])
+                    row[i] = tileIndices[i];
+            }
+        }
+        else
+        {
+            std::copy_n(tileIndices, count, row);
+        }
+
+        return UpdateRowMask(localX, localY, count);
+    }
+
+    int32_t TileChunk::FillRow(uint32_t localX, uint32_t localY, uint32_t count, uint16_t tileIndex)
+    {
+        LUMINA_ASSERT(localX + count <= SIZE && localY < SIZE, "TileChunk::FillRow: Row segment out of bounds");
+
+        std::fill_n(m_TileIndices.data() + GetLocalIndex(localX, localY), count, tileIndex);
+        return UpdateRowMask(localX, localY, count);
+    }
+
+    int32_t TileChunk::FillMasked(const std::array<uint32_t, SIZE>& rowMasks, uint16_t tileIndex)
+    {
+        int32_t paintedDelta = 0;
+        for (uint32_t localY = 0; localY < SIZE; localY++)
+        {
+            uint32_t mask = rowMasks[localY];
+            if (mask == 0)
+                continue;
+
+            if (mask == ~0u)
+            {
+                paintedDelta += FillRow(0, localY, SIZE, tileIndex);
+                continue;
+            }
+
+            uint16_t* row = m_TileIndices.data() + GetLocalIndex(0, localY);
+            while (mask != 0)
+            {
+                row[BitUtils::CountTrailingZeros(mask)] = tileIndex;
+                mask &= mask - 1;
+            }
+            paintedDelta += UpdateRowMask(0, localY, SIZE);
+        }
+        return paintedDelta;
+    }
+
+    int32_t TileChunk::UpdateRowMask(uint32_t localX, uint32_t localY, uint32_t count)
+    {
+        const uint16_t* row = m_TileIndices.data() + GetLocalIndex(localX, localY);
+
+        uint32_t paintedMask = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            paintedMask |= static_cast<uint32_t>(row[i] != TilePalette::DEFAULT_INDEX) << (localX + i);
+        }
+
+        uint32_t spanMask = (count < SIZE ? (1u << count) - 1 : ~0u) << localX;
+        uint32_t previousMask = m_RowMasks[localY];
+        m_RowMasks[localY] = (previousMask & ~spanMask) | paintedMask;
+
+        int32_t paintedDelta = static_cast<int32_t>(BitUtils::PopCount(m_RowMasks[localY])) - static_cast<int32_t>(BitUtils::PopCount(previousMask));
+        m_PaintedCount += paintedDelta;
+        return paintedDelta;
+    }
+
+    void TileChunk::ClearOutside(uint32_t width, uint32_t height)
+    {
+        // Whole row tails are reset at once, rows without painted tiles past the edge are skipped
+        for (uint32_t y = 0; y < SIZE; y++)
+        {
+            uint32_t startX = y < height ? std::min(width, SIZE) : 0;
+            uint32_t keepMask = startX < SIZE ? (1u << startX) - 1 : ~0u;
+            uint32_t clearedMask = m_RowMasks[y] & ~keepMask;
+            if (clearedMask == 0)
+                continue;
+
+            auto row = m_TileIndices.begin() + GetLocalIndex(0, y);
+            std::fill(row + startX, row + SIZE, TilePalette::DEFAULT_INDEX);
+
+            m_RowMasks[y] &= keepMask;
+            m_PaintedCount -= BitUtils::PopCount(clearedMask);
+        }
+    }
+
+    uint32_t TileChunk::GetColumnMask() const
+    {
+        uint32_t mask = 0;
+        for (uint32_t rowMask : m_RowMasks)
+        {
+            mask |= rowMask;
+        }
+        return mask;
+    }
+
+    uint32_t TileChunk::CountMatching(const uint8_t* matches) const
+    {
+        // Branch-free gather so the loop stays a straight stream over the index column
+        uint32_t count = 0;
+        for (uint16_t tileIndex : m_TileIndices)
+        {
+            count += matches[tileIndex];
+        }
+        return count;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "ColumnSpan.h"
+#include "TilePalette.h"
+
+namespace Tiles
+{
+    // Square block of tile palette indices. TileLayer only allocates chunks that hold at least one
+    // non-default tile, so empty regions of a layer cost nothing. Since unpainted tiles always
+    // intern to TilePalette::DEFAULT_INDEX, "non-default" and "painted" are the same thing here.
+    //
+    // Tile attributes live in the palette's columns, so a chunk is a single contiguous column
+    // of 16 bit indices that scans stream through.
+    class TileChunk
+    {
+    public:
+        static constexpr uint32_t SHIFT = 5;
+        static constexpr uint32_t SIZE = 1 << SHIFT;                   // Width and height in tiles
+        static constexpr uint32_t MASK = SIZE - 1;
+        static constexpr uint32_t TILE_COUNT = SIZE * SIZE;
+
+        TileChunk() = default;
+        ~TileChunk() = default;
+
+        uint16_t GetTileIndex(uint32_t localX, uint32_t localY) const { return m_TileIndices[GetLocalIndex(localX, localY)]; }
+
+        // Returns the change in painted tiles: -1, 0 or 1
+        int32_t SetTileIndex(uint32_t localX, uint32_t localY, uint16_t tileIndex);
+
+        // Write or fill count tiles of a row starting at localX, returning the change in painted tiles.
+        // mask holds one byte per written tile, tiles with a zero byte keep their index.
+        int32_t WriteRow(uint32_t localX, uint32_t localY, const uint16_t* tileIndices, uint32_t count, const uint8_t* mask = nullptr);
+        int32_t FillRow(uint32_t localX, uint32_t localY, uint32_t count, uint16_t tileIndex);
+
+        // Fills every tile whose bit is set in rowMasks (same layout as GetRowMask), returns the change in painted tiles
+        int32_t FillMasked(const std::array<uint32_t, SIZE>& rowMasks, uint16_t tileIndex);
+
+        // First of the SIZE contiguous indices of a row
+        const uint16_t* GetRow(uint32_t localY) const { return m_TileIndices.data() + GetLocalIndex(0, localY); }
+
+        // Resets every tile outside of [0, width) x [0, height) in local coordinates
+        void ClearOutside(uint32_t width, uint32_t height);
+
+        // Bit x of a row mask is set when the tile at (x, localY) is painted
+        uint32_t GetRowMask(uint32_t localY) const { return m_RowMasks[localY]; }
+        uint32_t GetColumnMask() const;
+
+        uint32_t GetPaintedCount() const { return m_PaintedCount; }
+        bool IsEmpty() const { return m_PaintedCount == 0; }
+
+        // Palette index column, indexed by GetLocalIndex
+        ColumnSpan<const uint16_t> GetTileIndices() const { return { m_TileIndices.data(), TILE_COUNT }; }
+
+        // Number of tiles whose palette entry is flagged in matches (one byte per palette entry, 0 or 1)
+        uint32_t CountMatching(const uint8_t* matches) const;
+
+        // Layer generation of the last write, see TileLayer::ForEachChunkChangedSince
+        uint64_t GetGeneration() const { return m_Generation; }
+        void SetGeneration(uint64_t generation) { m_Generation = generation; }
+
+        static uint32_t GetLocalIndex(uint32_t localX, uint32_t localY) { return (localY << SHIFT) | localX; }
+
+        // Chunk containing a tile coordinate, the arithmetic shift rounds negative coordinates down
+        static int32_t GetChunkCoord(int32_t tile) { return tile >> SHIFT; }
+        static uint32_t GetLocalCoord(int32_t tile) { return static_cast<uint32_t>(tile) & MASK; }
+
+    private:
+        // Rebuilds the row mask bits of [localX, localX + count) from the indices
+        int32_t UpdateRowMask(uint32_t localX, uint32_t localY, uint32_t count);
+
+    private:
+        std::array<uint16_t, TILE_COUNT> m_TileIndices = {};           // Row-major palette indices within the chunk
+        std::array<uint32_t, SIZE> m_RowMasks = {};                    // Painted occupancy bitmap, one word per row
+        uint32_t m_PaintedCount = 0;                                    // Number of painted (non-default) tiles
+        uint64_t m_Generation = 0;                                      // Generation this chunk was last written at
+    };
+}
@@ -0,0 +1,166 @@
+#include "TileDelta.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "BitUtils.h"
+
+namespace Tiles
+{
+    namespace
+    {
+        // Bits [start, end) of a chunk row
+        uint32_t GetSpanMask(uint32_t start, uint32_t end)
+        {
+            return (end - start < TileChunk::SIZE ? (1u << (end - start)) - 1 : ~0u) << start;
+        }
+    }
+
+    void TileDelta::AddChunk(int32_t chunkX, int32_t chunkY, const RowMasks& rowMasks, uint16_t oldTileIndex)
+    {
+        uint32_t firstRun = static_cast<uint32_t>(m_Runs.size());
+        for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+        {
+            uint32_t mask = rowMasks[localY];
+            while (mask != 0)
+            {
+                uint32_t start = BitUtils::CountTrailingZeros(mask);
+                uint32_t shifted = ~(mask >> start);
+                uint32_t end = shifted == 0 ? TileChunk::SIZE : start + BitUtils::CountTrailingZeros(shifted);
+                mask &= end < TileChunk::SIZE ? ~0u << end : 0;
+
+                AddRun(localY, start, end, oldTileIndex);
+            }
+        }
+
+        if (m_Runs.size() > firstRun)
+            m_Chunks.push_back({ chunkX, chunkY, firstRun, static_cast<uint32_t>(m_Runs.size()) - firstRun });
+    }
+
+    TileDelta TileDelta::FromPaintedTiles(const TileLayer& layer)
+    {
+        TileDelta delta;
+        layer.ForEachChunk([&](int32_t chunkX, int32_t chunkY, const TileChunk& chunk)
+            {
+                uint32_t firstRun = static_cast<uint32_t>(delta.m_Runs.size());
+                for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+                {
+                    // Painted tiles split into runs of equal indices
+                    const uint16_t* row = chunk.GetRow(localY);
+                    uint32_t mask = chunk.GetRowMask(localY);
+                    while (mask != 0)
+                    {
+                        uint32_t start = BitUtils::CountTrailingZeros(mask);
+                        uint32_t end = start + 1;
+                        while (end < TileChunk::SIZE && ((mask >> end) & 1u) && row[end] == row[start])
+                            end++;
+                        mask &= end < TileChunk::SIZE ? ~0u << end : 0;
+
+                        delta.AddRun(localY, start, end, row[start]);
+                    }
+                }
+
+                if (delta.m_Runs.size() > firstRun)
+                    delta.m_Chunks.push_back({ chunkX, chunkY, firstRun, static_cast<uint32_t>(delta.m_Runs.size()) - firstRun });
+            });
+        return delta;
+    }
+
+    void TileDelta::Apply(TileLayer& layer, uint16_t tileIndex) const
+    {
+        for (const ChunkRuns& chunk : m_Chunks)
+        {
+            RowMasks rowMasks = {};
+            for (uint32_t i = chunk.FirstRun; i < chunk.FirstRun + chunk.RunCount; i++)
+            {
+                rowMasks[m_Runs[i].Y] |= GetSpanMask(m_Runs[i].Start, m_Runs[i].End);
+            }
+            layer.FillChunkMasked(chunk.ChunkX, chunk.ChunkY, rowMasks, tileIndex);
+        }
+    }
+
+    void TileDelta::Restore(TileLayer& layer) const
+    {
+        std::vector<uint16_t> oldTileIndices;
+        for (const ChunkRuns& chunk : m_Chunks)
+        {
+            auto firstRun = m_Runs.begin() + chunk.FirstRun;
+            auto lastRun = firstRun + chunk.RunCount;
+
+            // One masked fill per distinct old index, fills and clears only ever have a few
+            oldTileIndices.clear();
+            for (auto run = firstRun; run != lastRun; ++run)
+            {
+                if (std::find(oldTileIndices.begin(), oldTileIndices.end(), run->OldTileIndex) == oldTileIndices.end())
+                    oldTileIndices.push_back(run->OldTileIndex);
+            }
+
+            for (uint16_t oldTileIndex : oldTileIndices)
+            {
+                RowMasks rowMasks = {};
+                for (auto run = firstRun; run != lastRun; ++run)
+                {
+                    if (run->OldTileIndex == oldTileIndex)
+                        rowMasks[run->Y] |= GetSpanMask(run->Start, run->End);
+                }
+                layer.FillChunkMasked(chunk.ChunkX, chunk.ChunkY, rowMasks, oldTileIndex);
+            }
+        }
+    }
+
+    void TileDelta::Serialize(ByteWriter& writer) const
+    {
+        writer.WriteVarUInt(m_Chunks.size());
+        for (const ChunkRuns& chunk : m_Chunks)
+        {
+            writer.WriteVarInt(chunk.ChunkX);
+            writer.WriteVarInt(chunk.ChunkY);
+            writer.WriteVarUInt(chunk.RunCount);
+
+            for (uint32_t i = chunk.FirstRun; i < chunk.FirstRun + chunk.RunCount; i++)
+            {
+                const Run& run = m_Runs[i];
+                writer.WriteU8(run.Y);
+                writer.WriteU8(run.Start);
+                writer.WriteU8(run.End);
+                writer.WriteVarUInt(run.OldTileIndex);
+            }
+        }
+    }
+
+    TileDelta TileDelta::Deserialize(ByteReader& reader)
+    {
+        TileDelta delta;
+        size_t chunkCount = static_cast<size_t>(reader.ReadVarUInt());
+        for (size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+        {
+            int32_t chunkX = static_cast<int32_t>(reader.ReadVarInt());
+            int32_t chunkY = static_cast<int32_t>(reader.ReadVarInt());
+            uint32_t runCount = static_cast<uint32_t>(reader.ReadVarUInt());
+
+            uint32_t firstRun = static_cast<uint32_t>(delta.m_Runs.size());
+            for (uint32_t i = 0; i < runCount; i++)
+            {
+                uint32_t localY = reader.ReadU8();
+                uint32_t start = reader.ReadU8();
+                uint32_t end = reader.ReadU8();
+                uint16_t oldTileIndex = static_cast<uint16_t>(reader.ReadVarUInt());
+
+                if (localY >= TileChunk::SIZE || start >= end || end > TileChunk::SIZE)
+                    throw std::runtime_error("TileDelta::Deserialize: Run out of chunk bounds");
+
+                delta.AddRun(localY, start, end, oldTileIndex);
+            }
+
+            if (runCount > 0)
+                delta.m_Chunks.push_back({ chunkX, chunkY, firstRun, runCount });
+        }
+        return delta;
+    }
+
+    void TileDelta::AddRun(uint32_t localY, uint32_t start, uint32_t end, uint16_t oldTileIndex)
+    {
+        m_Runs.push_back({ static_cast<uint8_t>(localY), static_cast<uint8_t>(start), static_cast<uint8_t>(end), oldTileIndex });
+        m_TileCount += end - start;
+    }
+}
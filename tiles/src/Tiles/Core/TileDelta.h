@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "ByteStream.h"
+#include "TileChunk.h"
+#include "TileLayer.h"
+
+namespace Tiles
+{
+    // Tiles changed by one edit of a layer, grouped by chunk. Every run of a chunk row remembers the
+    // palette index its tiles held before the edit, the index they were changed to is known to the
+    // command that made the edit. Undo and redo then only touch the changed tiles instead of
+    // keeping a copy of the whole layer.
+    class TileDelta
+    {
+    public:
+        using RowMasks = std::array<uint32_t, TileChunk::SIZE>;
+
+        TileDelta() = default;
+        ~TileDelta() = default;
+
+        // Adds the tiles of a chunk set in rowMasks (see TileChunk::GetRowMask), which all held oldTileIndex
+        void AddChunk(int32_t chunkX, int32_t chunkY, const RowMasks& rowMasks, uint16_t oldTileIndex);
+
+        // Every painted tile of the layer with its current index, the delta of clearing the layer
+        static TileDelta FromPaintedTiles(const TileLayer& layer);
+
+        // Writes tileIndex over every changed tile (redo)
+        void Apply(TileLayer& layer, uint16_t tileIndex) const;
+
+        // Writes back the index every changed tile held before the edit (undo)
+        void Restore(TileLayer& layer) const;
+
+        // Compact byte form, see Command::Serialize
+        void Serialize(ByteWriter& writer) const;
+        static TileDelta Deserialize(ByteReader& reader);
+
+        size_t GetTileCount() const { return m_TileCount; }
+        bool IsEmpty() const { return m_TileCount == 0; }
+
+        // Heap bytes held by the delta
+        size_t GetMemoryUsage() const { return m_Chunks.capacity() * sizeof(ChunkRuns) + m_Runs.capacity() * sizeof(Run); }
+
+    private:
+        // Tiles [Start, End) of a chunk row that all held OldTileIndex
+        struct Run
+        {
+            uint8_t Y;
+            uint8_t Start;
+            uint8_t End;
+            uint16_t OldTileIndex;
+        };
+
+        struct ChunkRuns
+        {
+            int32_t ChunkX;
+            int32_t ChunkY;
+            uint32_t FirstRun;                          // Index of the first run in m_Runs
+            uint32_t RunCount;                          // Runs of this chunk, ordered by row
+        };
+
+        void AddRun(uint32_t localY, uint32_t start, uint32_t end, uint16_t oldTileIndex);
+
+    private:
+        std::vector<ChunkRuns> m_Chunks;                // Changed chunks in the order they were added
+        std::vector<Run> m_Runs;                        // Runs of all chunks back to back
+        size_t m_TileCount = 0;                         // Number of changed tiles
+    };
+}
@@ -4,159 +4,985 @@
 
 #include "Constants.h"
 
+#include <algorithm>
+#include <atomic>
+
 namespace Tiles
 {
-	TileLayer::TileLayer(uint32_t width, uint32_t height) : m_Width(width), m_Height(height)
+	namespace
 	{
-		LUMINA_ASSERT((width * height) >= 0, "TileLayer::TileLayer: Size must be greater than 0");
-		m_Tiles.resize(width * height);
+		std::atomic<uint64_t> s_Generation = 0;
+
+		// Splits the row segment [x, x + count) at chunk edges, calls func(chunkX, localX, offset, length)
+		template<typename Func>
+		void ForEachRowSpan(int32_t x, uint32_t count, Func&& func)
+		{
+			uint32_t offset = 0;
+			while (offset < count)
+			{
+				int32_t tileX = x + static_cast<int32_t>(offset);
+				uint32_t localX = TileChunk::GetLocalCoord(tileX);
+				uint32_t length = std::min(TileChunk::SIZE - localX, count - offset);
+				func(TileChunk::GetChunkCoord(tileX), localX, offset, length);
+				offset += length;
+			}
+		}
+
+		// Whether writing tileIndices (where mask allows) over a chunk row span would leave it unchanged
+		bool IsSpanUnchanged(const TileChunk* chunk, uint32_t localX, uint32_t localY, const uint16_t* tileIndices, const uint8_t* mask, uint32_t length)
+		{
+			const uint16_t* row = chunk ? chunk->GetRow(localY) + localX : nullptr;
+			for (uint32_t i = 0; i < length; i++)
+			{
+				uint16_t current = row ? row[i] : TilePalette::DEFAULT_INDEX;
+				if ((!mask || mask[i]) && tileIndices[i] != current)
+					return false;
+			}
+			return true;
+		}
+	}
+
+	TileBounds TileBounds::Union(const TileBounds& other) const
+	{
+		if (IsEmpty())
+			return other;
+		if (other.IsEmpty())
+			return *this;
+
+		return {
+			std::min(MinX, other.MinX),
+			std::min(MinY, other.MinY),
+			std::max(MaxX, other.MaxX),
+			std::max(MaxY, other.MaxY)
+		};
+	}
+
+	TileLayer::TileLayer(uint32_t width, uint32_t height, const Ref<TilePalette>& palette)
+		: m_Width(width), m_Height(height), m_Palette(palette ? palette : CreateRef<TilePalette>()), m_Storage(CreateRef<ChunkStorage>())
+	{
+		Invalidate();
 	}
 
 	void TileLayer::Clear()
 	{
-		for (auto& tile : m_Tiles)
-		{
-			tile.Reset();
-		}
+		// Swap in fresh storage, snapshots sharing the old one keep their tiles
+		m_Storage = CreateRef<ChunkStorage>();
+		m_PaintedBounds = TileBounds();
+		m_PaintedBoundsDirty = false;
+		Invalidate();
+	}
+
+	void TileLayer::Invalidate()
+	{
+		m_InvalidatedGeneration = Touch();
+	}
+
+	uint64_t TileLayer::NextGeneration()
+	{
+		return s_Generation.fetch_add(1) + 1;
 	}
 
 	void TileLayer::Resize(uint32_t width, uint32_t height)
 	{
+		if (m_Unbounded)
+		{
+			LUMINA_LOG_INFO("TileLayer::Resize: Layer '{}' is unbounded, ignoring resize to {}x{}", m_Name, width, height);
+			return;
+		}
+
 		if (width == m_Width && height == m_Height)
 			return;
 
-		ResizeInternal(width, height);
+		// Growing only changes the valid area, chunks are allocated when tiles get painted
+		uint64_t generation = Touch();
+		if (width < m_Width || height < m_Height)
+			ClipTo(width, height, generation);
+
+		m_Width = width;
+		m_Height = height;
 	}
 
-	const Tile& TileLayer::GetTile(size_t x, size_t y) const
+	void TileLayer::SetUnbounded(bool unbounded)
 	{
-		LUMINA_ASSERT(IsValidPosition(x, y), "Const TileLayer::GetTile: Tile position out of bounds");
-		return m_Tiles[y * m_Width + x];
+		if (unbounded == m_Unbounded)
+			return;
+
+		uint64_t generation = Touch();
+		if (!unbounded)
+			ClipTo(m_Width, m_Height, generation);
+
+		m_Unbounded = unbounded;
 	}
 
-	Tile& TileLayer::GetTile(size_t x, size_t y)
+	void TileLayer::SetBounded(uint32_t width, uint32_t height)
 	{
-		LUMINA_ASSERT(IsValidPosition(x, y), "TileLayer::GetTile: Tile position out of bounds");
-		return m_Tiles[y * m_Width + x];
+		uint64_t generation = Touch();
+		ClipTo(width, height, generation);
+
+		m_Width = width;
+		m_Height = height;
+		m_Unbounded = false;
 	}
 
-	void TileLayer::SetName(const std::string& name)
+	Tile TileLayer::GetTile(int32_t x, int32_t y) const
 	{
-		if (name.empty())
+		return m_Palette->GetTile(GetTileIndex(x, y));
+	}
+
+	void TileLayer::SetTile(int32_t x, int32_t y, const Tile& tile)
+	{
+		uint16_t tileIndex;
+		if (m_Palette->Intern(tile, tileIndex))
+			SetTileIndex(x, y, tileIndex);
+	}
+
+	void TileLayer::ResetTile(int32_t x, int32_t y)
+	{
+		SetTileIndex(x, y, TilePalette::DEFAULT_INDEX);
+	}
+
+	const PackedTile& TileLayer::GetPackedTile(int32_t x, int32_t y) const
+	{
+		return m_Palette->GetPackedTile(GetTileIndex(x, y));
+	}
+
+	void TileLayer::SetPackedTile(int32_t x, int32_t y, const PackedTile& tile)
+	{
+		uint16_t tileIndex;
+		if (m_Palette->Intern(tile, tileIndex))
+			SetTileIndex(x, y, tileIndex);
+	}
+
+	uint16_t TileLayer::GetTileIndex(int32_t x, int32_t y) const
+	{
+		LUMINA_ASSERT(IsValidPosition(x, y), "TileLayer::GetTileIndex: Tile position out of bounds");
+		auto it = m_Storage->Chunks.find(GetChunkKey(TileChunk::GetChunkCoord(x), TileChunk::GetChunkCoord(y)));
+		if (it == m_Storage->Chunks.end())
+			return TilePalette::DEFAULT_INDEX;
+
+		return it->second->GetTileIndex(TileChunk::GetLocalCoord(x), TileChunk::GetLocalCoord(y));
+	}
+
+	void TileLayer::SetTileIndex(int32_t x, int32_t y, uint16_t tileIndex)
+	{
+		LUMINA_ASSERT(IsValidPosition(x, y), "TileLayer::SetTileIndex: Tile position out of bounds");
+		LUMINA_ASSERT(m_Palette->IsValidIndex(tileIndex), "TileLayer::SetTileIndex: Palette index {} out of range", tileIndex);
+
+		uint64_t chunkKey = GetChunkKey(TileChunk::GetChunkCoord(x), TileChunk::GetChunkCoord(y));
+		uint32_t localX = TileChunk::GetLocalCoord(x);
+		uint32_t localY = TileChunk::GetLocalCoord(y);
+
+		// Check before writing so no-op writes never unshare storage or chunks
+		auto current = m_Storage->Chunks.find(chunkKey);
+		uint16_t currentTileIndex = current != m_Storage->Chunks.end() ? current->second->GetTileIndex(localX, localY) : TilePalette::DEFAULT_INDEX;
+		if (currentTileIndex == tileIndex)
+			return;
+
+		uint64_t generation = Touch();
+
+		ChunkStorage& storage = GetMutableStorage();
+		Ref<TileChunk>& chunk = storage.Chunks[chunkKey];
+		if (!chunk)
 		{
-			LUMINA_LOG_INFO("TileLayer::SetName: Empty name provided, using default");
-			m_Name = "New Layer";
+			chunk = CreateRef<TileChunk>();
+			storage.FreedChunks.erase(chunkKey);
+		}
+
+		TileChunk& mutableChunk = GetMutableChunk(chunk);
+		int32_t paintedDelta = mutableChunk.SetTileIndex(localX, localY, tileIndex);
+		mutableChunk.SetGeneration(generation);
+
+		if (mutableChunk.IsEmpty())
+		{
+			storage.Chunks.erase(chunkKey);
+			storage.FreedChunks[chunkKey] = generation;
+		}
+
+		if (paintedDelta > 0)
+		{
+			storage.PaintedCount++;
+			UpdatePaintedBounds(x, y, paintedDelta);
+		}
+		else if (paintedDelta < 0)
+		{
+			storage.PaintedCount--;
+			UpdatePaintedBounds(x, y, paintedDelta);
+		}
+	}
+
+	void TileLayer::UpdatePaintedBounds(int32_t x, int32_t y, int32_t paintedDelta)
+	{
+		if (m_PaintedBoundsDirty)
+			return;
+
+		if (paintedDelta > 0)
+		{
+			m_PaintedBounds = m_PaintedBounds.Union({ x, y, x + 1, y + 1 });
 			return;
 		}
 
-		if (name != m_Name)
+		// Erasing a tile on the edge may shrink the bounds, defer the rescan until they are queried
+		if (x == m_PaintedBounds.MinX || x + 1 == m_PaintedBounds.MaxX ||
+			y == m_PaintedBounds.MinY || y + 1 == m_PaintedBounds.MaxY)
 		{
-			LUMINA_LOG_INFO("TileLayer::SetName: Changed layer name from '{}' to '{}'", m_Name, name);
-			m_Name = name;
+			m_PaintedBoundsDirty = true;
 		}
 	}
 
-	void TileLayer::SetWidth(uint32_t width)
+	const TileBounds& TileLayer::GetPaintedBounds() const
 	{
-		if (width != m_Width)
+		if (!m_PaintedBoundsDirty)
+			return m_PaintedBounds;
+
+		m_PaintedBounds = TileBounds();
+		m_PaintedBoundsDirty = false;
+
+		// Allocated chunks always hold at least one painted tile
+		ForEachChunk([&](int32_t chunkX, int32_t chunkY, const TileChunk& chunk)
+			{
+				uint32_t columnMask = chunk.GetColumnMask();
+
+				uint32_t minLocalY = 0;
+				while (chunk.GetRowMask(minLocalY) == 0)
+					minLocalY++;
+
+				uint32_t maxLocalY = TileChunk::SIZE;
+				while (chunk.GetRowMask(maxLocalY - 1) == 0)
+					maxLocalY--;
+
+				int32_t originX = chunkX * static_cast<int32_t>(TileChunk::SIZE);
+				int32_t originY = chunkY * static_cast<int32_t>(TileChunk::SIZE);
+				m_PaintedBounds = m_PaintedBounds.Union({
+					originX + static_cast<int32_t>(BitUtils::CountTrailingZeros(columnMask)),
+					originY + static_cast<int32_t>(minLocalY),
+					originX + static_cast<int32_t>(BitUtils::FindLastSet(columnMask)) + 1,
+					originY + static_cast<int32_t>(maxLocalY)
+					});
+			});
+
+		return m_PaintedBounds;
+	}
+
+	TileBounds TileLayer::GetBounds() const
+	{
+		if (m_Unbounded)
+			return GetPaintedBounds();
+
+		return { 0, 0, static_cast<int32_t>(m_Width), static_cast<int32_t>(m_Height) };
+	}
+
+	bool TileLayer::IsValidPosition(int32_t x, int32_t y) const
+	{
+		if (m_Unbounded)
+			return true;
+
+		return x >= 0 && y >= 0 && static_cast<uint32_t>(x) < m_Width && static_cast<uint32_t>(y) < m_Height;
+	}
+
+	size_t TileLayer::CountTilesWithFlags(uint8_t flags) const
+	{
+		// Unallocated chunks only hold default tiles, which have no flags set
+		if (flags == 0)
+			return GetTileCount();
+
+		ColumnSpan<const uint8_t> paletteFlags = m_Palette->GetFlags();
+		std::vector<uint8_t> matches(paletteFlags.GetSize());
+		for (size_t i = 0; i < paletteFlags.GetSize(); i++)
 		{
-			ResizeInternal(width, m_Height);
+			matches[i] = (paletteFlags[i] & flags) == flags;
 		}
+
+		return CountTilesMatching(matches);
 	}
 
-	void TileLayer::SetHeight(uint32_t height)
+	size_t TileLayer::CountTilesUsingAtlas(size_t atlasIndex) const
+	{
+		// Default tiles never reference an atlas, so only painted tiles can match
+		std::vector<uint8_t> matches = m_Palette->GetAtlasMatches(atlasIndex);
+		if (matches.empty())
+			return 0;
+
+		return CountTilesMatching(matches);
+	}
+
+	std::vector<TileLayer::ChunkUsage> TileLayer::FindAtlasUsage(size_t atlasIndex, const glm::vec4* textureCoords) const
+	{
+		std::vector<ChunkUsage> usage;
+
+		std::vector<uint8_t> matches = m_Palette->GetAtlasMatches(atlasIndex, textureCoords);
+		if (matches.empty())
+			return usage;
+
+		ForEachChunk([&](int32_t chunkX, int32_t chunkY, const TileChunk& chunk)
+			{
+				uint32_t tileCount = chunk.CountMatching(matches.data());
+				if (tileCount > 0)
+					usage.push_back({ chunkX, chunkY, tileCount });
+			});
+		return usage;
+	}
+
+	size_t TileLayer::CountTilesMatching(const std::vector<uint8_t>& matches) const
 	{
-		if (height != m_Height)
+		size_t count = 0;
+		ForEachChunk([&](int32_t, int32_t, const TileChunk& chunk)
+			{
+				count += chunk.CountMatching(matches.data());
+			});
+		return count;
+	}
+
+	bool TileLayer::SetPalette(const Ref<TilePalette>& palette)
+	{
+		if (palette == m_Palette)
+			return true;
+
+		// Every distinct index in use is looked up once, so the layer is left untouched when the
+		// destination palette has no room for the tiles it is missing
+		constexpr int32_t unmapped = -1;
+		constexpr int32_t missing = -2;
+		std::vector<int32_t> remap(m_Palette->GetEntryCount(), unmapped);
+		remap[TilePalette::DEFAULT_INDEX] = TilePalette::DEFAULT_INDEX;
+
+		size_t missingCount = 0;
+		for (const auto& [key, chunk] : m_Storage->Chunks)
+		{
+			const uint16_t* tileIndices = chunk->GetTileIndices().GetData();
+			for (uint32_t i = 0; i < TileChunk::TILE_COUNT; i++)
+			{
+				uint16_t oldIndex = tileIndices[i];
+				if (remap[oldIndex] != unmapped)
+					continue;
+
+				uint16_t newIndex;
+				if (palette->Find(m_Palette->GetPackedTile(oldIndex), newIndex))
+				{
+					remap[oldIndex] = newIndex;
+				}
+				else
+				{
+					remap[oldIndex] = missing;
+					missingCount++;
+				}
+			}
+		}
+
+		if (missingCount > TilePalette::MAX_ENTRY_COUNT - palette->GetEntryCount())
 		{
-			ResizeInternal(m_Width, height);
+			LUMINA_LOG_INFO("TileLayer::SetPalette: Palette has no room for {} more tiles, layer '{}' is unchanged", missingCount, m_Name);
+			return false;
 		}
+
+		// Indices no chunk uses map to the default entry, nothing reads them
+		std::vector<uint16_t> indexRemap(remap.size(), TilePalette::DEFAULT_INDEX);
+		for (size_t oldIndex = 0; oldIndex < remap.size(); oldIndex++)
+		{
+			uint16_t newIndex = TilePalette::DEFAULT_INDEX;
+			if (remap[oldIndex] == missing)
+				palette->Intern(m_Palette->GetPackedTile(static_cast<uint16_t>(oldIndex)), newIndex);
+			else if (remap[oldIndex] != unmapped)
+				newIndex = static_cast<uint16_t>(remap[oldIndex]);
+			indexRemap[oldIndex] = newIndex;
+		}
+
+		m_Palette = palette;
+		RemapTileIndices(indexRemap);
+		return true;
 	}
 
-	void TileLayer::ResizeInternal(uint32_t width, uint32_t height)
+	void TileLayer::RemapTileIndices(const std::vector<uint16_t>& indexRemap)
 	{
-		std::vector<Tile> newTiles(width * height);
+		ChunkStorage& storage = GetMutableStorage();
+		storage.PaintedCount = 0;
+
+		for (auto it = storage.Chunks.begin(); it != storage.Chunks.end();)
+		{
+			TileChunk& chunk = GetMutableChunk(it->second);
+			for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+			{
+				uint32_t mask = chunk.GetRowMask(localY);
+				while (mask != 0)
+				{
+					uint32_t localX = BitUtils::CountTrailingZeros(mask);
+					mask &= mask - 1;
+					chunk.SetTileIndex(localX, localY, indexRemap[chunk.GetTileIndex(localX, localY)]);
+				}
+			}
+
+			// Painted tiles can map to the default entry, so chunks may have emptied
+			if (chunk.IsEmpty())
+			{
+				it = storage.Chunks.erase(it);
+				continue;
+			}
+
+			storage.PaintedCount += chunk.GetPaintedCount();
+			++it;
+		}
+
+		m_PaintedBoundsDirty = true;
 
-		uint32_t copyWidth = std::min(width, m_Width);
-		uint32_t copyHeight = std::min(height, m_Height);
+		// Every index may have changed, consumers have to start over
+		Invalidate();
+	}
 
-		for (uint32_t y = 0; y < copyHeight; y++)
+	TileRegion TileLayer::CopyRegion(const TileBounds& bounds) const
+	{
+		TileRegion region(bounds.GetWidth(), bounds.GetHeight(), m_Palette);
+		for (uint32_t y = 0; y < region.GetHeight(); y++)
 		{
-			for (uint32_t x = 0; x < copyWidth; x++)
+			ReadRow(bounds.MinX, bounds.MinY + static_cast<int32_t>(y), region.GetWidth(), region.GetRow(y));
+		}
+		return region;
+	}
+
+	void TileLayer::FillRect(const TileBounds& bounds, const Tile& tile)
+	{
+		uint16_t tileIndex;
+		if (m_Palette->Intern(tile, tileIndex))
+			FillRect(bounds, tileIndex);
+	}
+
+	void TileLayer::FillRect(const TileBounds& bounds, uint16_t tileIndex)
+	{
+		LUMINA_ASSERT(m_Palette->IsValidIndex(tileIndex), "TileLayer::FillRect: Palette index {} out of range", tileIndex);
+
+		TileBounds target = ClipRect(bounds);
+		if (target.IsEmpty())
+			return;
+
+		uint64_t generation = NextGeneration();
+		bool changed = false;
+
+		// Chunk by chunk, so each chunk is looked up once for all of its rows
+		for (int32_t chunkY = TileChunk::GetChunkCoord(target.MinY); chunkY <= TileChunk::GetChunkCoord(target.MaxY - 1); chunkY++)
+		{
+			int64_t originY = static_cast<int64_t>(chunkY) * TileChunk::SIZE;
+			uint32_t minLocalY = static_cast<uint32_t>(std::max<int64_t>(target.MinY - originY, 0));
+			uint32_t maxLocalY = static_cast<uint32_t>(std::min<int64_t>(target.MaxY - originY, TileChunk::SIZE));
+
+			for (int32_t chunkX = TileChunk::GetChunkCoord(target.MinX); chunkX <= TileChunk::GetChunkCoord(target.MaxX - 1); chunkX++)
 			{
-				newTiles[y * width + x] = m_Tiles[y * m_Width + x];
+				int64_t originX = static_cast<int64_t>(chunkX) * TileChunk::SIZE;
+				uint32_t minLocalX = static_cast<uint32_t>(std::max<int64_t>(target.MinX - originX, 0));
+				uint32_t width = static_cast<uint32_t>(std::min<int64_t>(target.MaxX - originX, TileChunk::SIZE)) - minLocalX;
+
+				// Rectangles that already hold the tile never unshare storage or allocate chunks
+				const TileChunk* current = GetChunk(chunkX, chunkY);
+				bool unchanged = current ? true : tileIndex == TilePalette::DEFAULT_INDEX;
+				for (uint32_t localY = minLocalY; current && unchanged && localY < maxLocalY; localY++)
+				{
+					const uint16_t* row = current->GetRow(localY) + minLocalX;
+					unchanged = std::all_of(row, row + width, [&](uint16_t tile) { return tile == tileIndex; });
+				}
+				if (unchanged)
+					continue;
+
+				UpdateChunk(GetChunkKey(chunkX, chunkY), generation, [&](TileChunk& chunk)
+					{
+						int32_t paintedDelta = 0;
+						for (uint32_t localY = minLocalY; localY < maxLocalY; localY++)
+						{
+							paintedDelta += chunk.FillRow(minLocalX, localY, width, tileIndex);
+						}
+						return paintedDelta;
+					});
+				changed = true;
 			}
 		}
 
-		m_Tiles = std::move(newTiles);
-		m_Width = width;
-		m_Height = height;
+		if (changed)
+		{
+			m_Generation = generation;
+			m_PaintedBoundsDirty = true;
+		}
 	}
 
-	nlohmann::json TileLayer::ToJSON() const
+	void TileLayer::FillChunkMasked(int32_t chunkX, int32_t chunkY, const std::array<uint32_t, TileChunk::SIZE>& rowMasks, uint16_t tileIndex)
 	{
-		nlohmann::json jsonLayer;
+		LUMINA_ASSERT(m_Palette->IsValidIndex(tileIndex), "TileLayer::FillChunkMasked: Palette index {} out of range", tileIndex);
 
-		jsonLayer[JSON::TileLayer::Name] = GetName();
-		jsonLayer[JSON::TileLayer::Width] = GetWidth();
-		jsonLayer[JSON::TileLayer::Height] = GetHeight();
-		jsonLayer[JSON::TileLayer::Visible] = GetVisibility();
-		jsonLayer[JSON::TileLayer::RenderGroup] = GetRenderGroup();
+		// Bounded layers never hold tiles outside of the layer
+		std::array<uint32_t, TileChunk::SIZE> clippedMasks = rowMasks;
+		if (!m_Unbounded)
+		{
+			int64_t originX = static_cast<int64_t>(chunkX) * TileChunk::SIZE;
+			int64_t originY = static_cast<int64_t>(chunkY) * TileChunk::SIZE;
+			int64_t columns = std::clamp<int64_t>(static_cast<int64_t>(m_Width) - originX, 0, TileChunk::SIZE);
+			uint32_t columnMask = originX < 0 ? 0 : columns < TileChunk::SIZE ? (1u << columns) - 1 : ~0u;
 
-		nlohmann::json tilesArray = nlohmann::json::array();
-		for (uint32_t y = 0; y < GetHeight(); y++)
+			for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+			{
+				int64_t y = originY + localY;
+				clippedMasks[localY] &= y >= 0 && y < static_cast<int64_t>(m_Height) ? columnMask : 0;
+			}
+		}
+
+		const TileChunk* current = GetChunk(chunkX, chunkY);
+		bool unchanged = true;
+		for (uint32_t localY = 0; unchanged && localY < TileChunk::SIZE; localY++)
 		{
-			nlohmann::json rowArray = nlohmann::json::array();
-			for (uint32_t x = 0; x < GetWidth(); x++)
+			uint32_t mask = clippedMasks[localY];
+			while (unchanged && mask != 0)
 			{
-				const Tile& tile = GetTile(x, y);
-				rowArray.push_back(tile.ToJSON());
+				uint32_t localX = BitUtils::CountTrailingZeros(mask);
+				mask &= mask - 1;
+				unchanged = (current ? current->GetTileIndex(localX, localY) : TilePalette::DEFAULT_INDEX) == tileIndex;
 			}
-			tilesArray.push_back(rowArray);
 		}
-		jsonLayer[JSON::TileLayer::Tiles] = tilesArray;
+		if (unchanged)
+			return;
+
+		uint64_t generation = NextGeneration();
+		UpdateChunk(GetChunkKey(chunkX, chunkY), generation, [&](TileChunk& chunk)
+			{
+				return chunk.FillMasked(clippedMasks, tileIndex);
+			});
+
+		m_Generation = generation;
+		m_PaintedBoundsDirty = true;
+	}
+
+	void TileLayer::SetChunkTiles(int32_t chunkX, int32_t chunkY, const uint16_t* tileIndices)
+	{
+		uint64_t generation = NextGeneration();
+		UpdateChunk(GetChunkKey(chunkX, chunkY), generation, [&](TileChunk& chunk)
+			{
+				int32_t paintedDelta = 0;
+				for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+				{
+					paintedDelta += chunk.WriteRow(0, localY, tileIndices + localY * TileChunk::SIZE, TileChunk::SIZE);
+				}
+
+				if (!m_Unbounded)
+				{
+					int64_t originX = static_cast<int64_t>(chunkX) * TileChunk::SIZE;
+					int64_t originY = static_cast<int64_t>(chunkY) * TileChunk::SIZE;
+					uint32_t columns = originX < 0 ? 0 : static_cast<uint32_t>(std::clamp<int64_t>(static_cast<int64_t>(m_Width) - originX, 0, TileChunk::SIZE));
+					uint32_t rows = originY < 0 ? 0 : static_cast<uint32_t>(std::clamp<int64_t>(static_cast<int64_t>(m_Height) - originY, 0, TileChunk::SIZE));
+
+					uint32_t paintedCount = chunk.GetPaintedCount();
+					chunk.ClearOutside(columns, rows);
+					paintedDelta -= static_cast<int32_t>(paintedCount - chunk.GetPaintedCount());
+				}
+
+				return paintedDelta;
+			});
+
+		m_Generation = generation;
+		m_PaintedBoundsDirty = true;
+	}
+
+	void TileLayer::SetRowTiles(int32_t x, int32_t y, uint32_t count, const uint16_t* tileIndices)
+	{
+		TileBounds target = ClipRect({ x, y, x + static_cast<int32_t>(count), y + 1 });
+		if (target.IsEmpty())
+			return;
+
+		uint64_t generation = NextGeneration();
+		if (WriteRow(target.MinX, y, target.GetWidth(), tileIndices + (target.MinX - x), nullptr, generation))
+		{
+			m_Generation = generation;
+			m_PaintedBoundsDirty = true;
+		}
+	}
+
+	void TileLayer::PasteRegion(int32_t x, int32_t y, const TileRegion& region, const std::vector<uint8_t>& mask)
+	{
+		LUMINA_ASSERT(mask.empty() || mask.size() == region.GetTileCount(), "TileLayer::PasteRegion: Mask has {} entries for {} tiles", mask.size(), region.GetTileCount());
+
+		TileBounds target = ClipRect({ x, y, x + static_cast<int32_t>(region.GetWidth()), y + static_cast<int32_t>(region.GetHeight()) });
+		if (target.IsEmpty())
+			return;
+
+		// Regions copied from another palette are re-interned, each distinct source index is only looked up once.
+		// Tiles a full palette can't take are masked out, the cells under them keep their tile.
+		constexpr int32_t unmapped = -1;
+		constexpr int32_t paletteFull = -2;
+		const Ref<TilePalette>& sourcePalette = region.GetPalette();
+		bool remapIndices = sourcePalette && sourcePalette != m_Palette;
+		std::vector<int32_t> remap;
+		std::vector<uint16_t> remappedRow;
+		std::vector<uint8_t> remappedMask;
+		size_t skippedCount = 0;
+		if (remapIndices)
+		{
+			remap.assign(sourcePalette->GetEntryCount(), unmapped);
+			remap[TilePalette::DEFAULT_INDEX] = TilePalette::DEFAULT_INDEX;
+			remappedRow.assign(target.GetWidth(), TilePalette::DEFAULT_INDEX);
+			remappedMask.assign(target.GetWidth(), 0);
+		}
+
+		uint32_t sourceX = static_cast<uint32_t>(target.MinX - x);
+		uint32_t width = target.GetWidth();
+		uint64_t generation = NextGeneration();
+		bool changed = false;
+
+		for (int32_t targetY = target.MinY; targetY < target.MaxY; targetY++)
+		{
+			uint32_t sourceY = static_cast<uint32_t>(targetY - y);
+			const uint16_t* source = region.GetRow(sourceY) + sourceX;
+			const uint8_t* rowMask = mask.empty() ? nullptr : mask.data() + region.GetIndex(sourceX, sourceY);
+
+			if (remapIndices)
+			{
+				for (uint32_t i = 0; i < width; i++)
+				{
+					remappedMask[i] = 0;
+					if (rowMask && !rowMask[i])
+						continue;
+
+					uint16_t sourceIndex = source[i];
+					if (remap[sourceIndex] == unmapped)
+					{
+						uint16_t tileIndex;
+						remap[sourceIndex] = m_Palette->Intern(sourcePalette->GetPackedTile(sourceIndex), tileIndex) ? tileIndex : paletteFull;
+					}
+
+					if (remap[sourceIndex] == paletteFull)
+					{
+						skippedCount++;
+						continue;
+					}
+
+					remappedRow[i] = static_cast<uint16_t>(remap[sourceIndex]);
+					remappedMask[i] = 1;
+				}
+				source = remappedRow.data();
+				rowMask = remappedMask.data();
+			}
+
+			changed |= WriteRow(target.MinX, targetY, width, source, rowMask, generation);
+		}
+
+		if (skippedCount > 0)
+		{
+			LUMINA_LOG_INFO("TileLayer::PasteRegion: Palette is full, {} tiles were not pasted", skippedCount);
+		}
+
+		if (changed)
+		{
+			m_Generation = generation;
+			m_PaintedBoundsDirty = true;
+		}
+	}
+
+	void TileLayer::Shift(int32_t dx, int32_t dy)
+	{
+		if (dx == 0 && dy == 0)
+			return;
+
+		// Rebuild into fresh storage, the old storage stays alive until every row has been moved
+		Ref<ChunkStorage> source = m_Storage;
+		m_Storage = CreateRef<ChunkStorage>();
+
+		uint64_t generation = NextGeneration();
+		TileBounds target = ClipRect({ INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX });
+
+		for (const auto& [chunkKey, chunk] : source->Chunks)
+		{
+			int32_t originX = GetChunkX(chunkKey) * static_cast<int32_t>(TileChunk::SIZE) + dx;
+			int32_t originY = GetChunkY(chunkKey) * static_cast<int32_t>(TileChunk::SIZE) + dy;
+
+			int32_t startX = std::max(originX, target.MinX);
+			int32_t endX = std::min(originX + static_cast<int32_t>(TileChunk::SIZE), target.MaxX);
+			if (startX >= endX)
+				continue;
+
+			for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+			{
+				int32_t y = originY + static_cast<int32_t>(localY);
+				if (chunk->GetRowMask(localY) == 0 || y < target.MinY || y >= target.MaxY)
+					continue;
+
+				const uint16_t* row = chunk->GetRow(localY) + (startX - originX);
+				WriteRow(startX, y, static_cast<uint32_t>(endX - startX), row, nullptr, generation);
+			}
+		}
+
+		m_PaintedBoundsDirty = true;
+		Invalidate();
+	}
 
-		return jsonLayer;
+	TileBounds TileLayer::ClipRect(const TileBounds& bounds) const
+	{
+		if (m_Unbounded)
+			return bounds;
+
+		return {
+			std::max(bounds.MinX, 0),
+			std::max(bounds.MinY, 0),
+			std::min(bounds.MaxX, static_cast<int32_t>(m_Width)),
+			std::min(bounds.MaxY, static_cast<int32_t>(m_Height))
+		};
 	}
 
-	TileLayer TileLayer::FromJSON(const nlohmann::json& jsonLayer)
+	void TileLayer::ReadRow(int32_t x, int32_t y, uint32_t count, uint16_t* tileIndices) const
 	{
-		uint32_t width = jsonLayer.at(JSON::TileLayer::Width).get<uint32_t>();
-		uint32_t height = jsonLayer.at(JSON::TileLayer::Height).get<uint32_t>();
+		int32_t chunkY = TileChunk::GetChunkCoord(y);
+		uint32_t localY = TileChunk::GetLocalCoord(y);
 
-		TileLayer layer(width, height);
+		ForEachRowSpan(x, count, [&](int32_t chunkX, uint32_t localX, uint32_t offset, uint32_t length)
+			{
+				const TileChunk* chunk = GetChunk(chunkX, chunkY);
+				if (chunk)
+					std::copy_n(chunk->GetRow(localY) + localX, length, tileIndices + offset);
+				else
+					std::fill_n(tileIndices + offset, length, TilePalette::DEFAULT_INDEX);
+			});
+	}
 
-		if (jsonLayer.contains(JSON::TileLayer::Name))
+	template<typename WriteChunk>
+	void TileLayer::UpdateChunk(uint64_t chunkKey, uint64_t generation, WriteChunk&& writeChunk)
+	{
+		ChunkStorage& storage = GetMutableStorage();
+		Ref<TileChunk>& chunk = storage.Chunks[chunkKey];
+		if (!chunk)
 		{
-			std::string name = jsonLayer[JSON::TileLayer::Name].get<std::string>();
-			layer.SetName(name);
+			chunk = CreateRef<TileChunk>();
+			storage.FreedChunks.erase(chunkKey);
 		}
 
-		if (jsonLayer.contains(JSON::TileLayer::Visible))
+		TileChunk& mutableChunk = GetMutableChunk(chunk);
+		int32_t paintedDelta = writeChunk(mutableChunk);
+		mutableChunk.SetGeneration(generation);
+		storage.PaintedCount = static_cast<size_t>(static_cast<int64_t>(storage.PaintedCount) + paintedDelta);
+
+		if (mutableChunk.IsEmpty())
 		{
-			bool visible = jsonLayer[JSON::TileLayer::Visible].get<bool>();
-			layer.SetVisibility(visible);
+			storage.Chunks.erase(chunkKey);
+			storage.FreedChunks[chunkKey] = generation;
 		}
+	}
+
+	template<typename SkipSpan, typename WriteSpan>
+	bool TileLayer::WriteRowSpans(int32_t x, int32_t y, uint32_t count, uint64_t generation, SkipSpan&& skipSpan, WriteSpan&& writeSpan)
+	{
+		int32_t chunkY = TileChunk::GetChunkCoord(y);
+		uint32_t localY = TileChunk::GetLocalCoord(y);
+		bool written = false;
+
+		ForEachRowSpan(x, count, [&](int32_t chunkX, uint32_t localX, uint32_t offset, uint32_t length)
+			{
+				// Spans that change nothing never unshare storage or allocate chunks
+				uint64_t chunkKey = GetChunkKey(chunkX, chunkY);
+				auto current = m_Storage->Chunks.find(chunkKey);
+				const TileChunk* currentChunk = current != m_Storage->Chunks.end() ? current->second.get() : nullptr;
+				if (skipSpan(currentChunk, localX, localY, offset, length))
+					return;
+
+				UpdateChunk(chunkKey, generation, [&](TileChunk& chunk)
+					{
+						return writeSpan(chunk, localX, localY, offset, length);
+					});
+				written = true;
+			});
+
+		return written;
+	}
+
+	bool TileLayer::WriteRow(int32_t x, int32_t y, uint32_t count, const uint16_t* tileIndices, const uint8_t* mask, uint64_t generation)
+	{
+		return WriteRowSpans(x, y, count, generation,
+			[&](const TileChunk* chunk, uint32_t localX, uint32_t localY, uint32_t offset, uint32_t length)
+			{
+				return IsSpanUnchanged(chunk, localX, localY, tileIndices + offset, mask ? mask + offset : nullptr, length);
+			},
+			[&](TileChunk& chunk, uint32_t localX, uint32_t localY, uint32_t offset, uint32_t length)
+			{
+				return chunk.WriteRow(localX, localY, tileIndices + offset, length, mask ? mask + offset : nullptr);
+			});
+	}
+
+	size_t TileLayer::GetMemoryUsage() const
+	{
+		// Hash map nodes hold the key, the chunk pointer and the bucket link
+		constexpr size_t chunkNodeSize = sizeof(uint64_t) + sizeof(Ref<TileChunk>) + sizeof(void*);
+		constexpr size_t freedNodeSize = 2 * sizeof(uint64_t) + sizeof(void*);
 
-		if (jsonLayer.contains(JSON::TileLayer::RenderGroup))
+		return sizeof(ChunkStorage) +
+			m_Storage->Chunks.size() * (sizeof(TileChunk) + chunkNodeSize) +
+			m_Storage->Chunks.bucket_count() * sizeof(void*) +
+			m_Storage->FreedChunks.size() * freedNodeSize +
+			m_Storage->FreedChunks.bucket_count() * sizeof(void*);
+	}
+
+	const TileChunk* TileLayer::GetChunk(int32_t chunkX, int32_t chunkY) const
+	{
+		auto it = m_Storage->Chunks.find(GetChunkKey(chunkX, chunkY));
+		return it != m_Storage->Chunks.end() ? it->second.get() : nullptr;
+	}
+
+	void TileLayer::SetName(const std::string& name)
+	{
+		if (name.empty())
 		{
-			int renderGroup = jsonLayer[JSON::TileLayer::RenderGroup].get<int>();
-			layer.SetRenderGroup(static_cast<RenderGroup>(renderGroup));
+			LUMINA_LOG_INFO("TileLayer::SetName: Empty name provided, using default");
+			m_Name = "New Layer";
+			return;
 		}
 
-		if (jsonLayer.contains(JSON::TileLayer::Tiles))
+		if (name != m_Name)
 		{
-			const auto& tilesArray = jsonLayer[JSON::TileLayer::Tiles];
-			for (uint32_t y = 0; y < height && y < tilesArray.size(); y++)
+			LUMINA_LOG_INFO("TileLayer::SetName: Changed layer name from '{}' to '{}'", m_Name, name);
+			m_Name = name;
+			Touch();
+		}
+	}
+
+	void TileLayer::SetWidth(uint32_t width)
+	{
+		Resize(width, m_Height);
+	}
+
+	void TileLayer::SetHeight(uint32_t height)
+	{
+		Resize(m_Width, height);
+	}
+
+	void TileLayer::ClipTo(uint32_t width, uint32_t height, uint64_t generation)
+	{
+		ChunkStorage& storage = GetMutableStorage();
+
+		for (auto it = storage.Chunks.begin(); it != storage.Chunks.end();)
+		{
+			int64_t originX = static_cast<int64_t>(GetChunkX(it->first)) * TileChunk::SIZE;
+			int64_t originY = static_cast<int64_t>(GetChunkY(it->first)) * TileChunk::SIZE;
+
+			// Chunks entirely outside are dropped
+			if (originX < 0 || originY < 0 || originX >= width || originY >= height)
+			{
+				storage.PaintedCount -= it->second->GetPaintedCount();
+				storage.FreedChunks[it->first] = generation;
+				it = storage.Chunks.erase(it);
+				continue;
+			}
+
+			// Chunks straddling the new edge must not keep tiles outside of the layer
+			uint32_t localWidth = static_cast<uint32_t>(std::min<int64_t>(width - originX, TileChunk::SIZE));
+			uint32_t localHeight = static_cast<uint32_t>(std::min<int64_t>(height - originY, TileChunk::SIZE));
+			if (localWidth < TileChunk::SIZE || localHeight < TileChunk::SIZE)
 			{
-				const auto& rowArray = tilesArray[y];
-				for (uint32_t x = 0; x < width && x < rowArray.size(); x++)
+				TileChunk& chunk = GetMutableChunk(it->second);
+				uint32_t paintedBefore = chunk.GetPaintedCount();
+				chunk.ClearOutside(localWidth, localHeight);
+
+				if (chunk.GetPaintedCount() != paintedBefore)
+				{
+					storage.PaintedCount -= paintedBefore - chunk.GetPaintedCount();
+					chunk.SetGeneration(generation);
+				}
+
+				if (chunk.IsEmpty())
 				{
-					Tile tile = Tile::FromJSON(rowArray[x]);
-					layer.GetTile(x, y) = tile;
+					storage.FreedChunks[it->first] = generation;
+					it = storage.Chunks.erase(it);
+					continue;
 				}
 			}
+
+			++it;
 		}
 
-		return layer;
+		m_PaintedBoundsDirty = true;
+	}
+
+	TileLayer::ChunkStorage& TileLayer::GetMutableStorage()
+	{
+		// Copies the chunk table only, the chunks themselves stay shared until written
+		if (m_Storage.use_count() > 1)
+			m_Storage = CreateRef<ChunkStorage>(*m_Storage);
+
+		return *m_Storage;
+	}
+
+	TileChunk& TileLayer::GetMutableChunk(Ref<TileChunk>& chunk)
+	{
+		if (chunk.use_count() > 1)
+			chunk = CreateRef<TileChunk>(*chunk);
+
+		return *chunk;
+	}
+
+	void TileLayer::WriteJSON(JsonWriter& writer) const
+	{
+		// Unbounded layers only save the area covered by painted tiles
+		TileBounds bounds = GetBounds();
+
+		writer.BeginObject();
+		writer.Key(JSON::TileLayer::Name);
+		writer.String(GetName());
+		writer.Key(JSON::TileLayer::Width);
+		writer.UInt(bounds.GetWidth());
+		writer.Key(JSON::TileLayer::Height);
+		writer.UInt(bounds.GetHeight());
+		writer.Key(JSON::TileLayer::OriginX);
+		writer.Int(bounds.MinX);
+		writer.Key(JSON::TileLayer::OriginY);
+		writer.Int(bounds.MinY);
+		writer.Key(JSON::TileLayer::Unbounded);
+		writer.Bool(IsUnbounded());
+		writer.Key(JSON::TileLayer::Visible);
+		writer.Bool(GetVisibility());
+		writer.Key(JSON::TileLayer::RenderGroup);
+		writer.Int(static_cast<int64_t>(GetRenderGroup()));
+
+		// Only painted tiles are saved, as runs of one palette index along a row. Unpainted tiles are
+		// implied, so chunk rows without painted tiles are skipped without looking at their tiles.
+		writer.Key(JSON::TileLayer::TileRuns);
+		writer.BeginArray();
+		for (int32_t y = bounds.MinY; y < bounds.MaxY; y++)
+		{
+			int32_t chunkY = TileChunk::GetChunkCoord(y);
+			uint32_t localY = TileChunk::GetLocalCoord(y);
+
+			int32_t runX = 0;
+			uint32_t runLength = 0;
+			uint16_t runIndex = TilePalette::DEFAULT_INDEX;
+			auto endRun = [&]()
+				{
+					if (runLength == 0)
+						return;
+
+					writer.Int(runX);
+					writer.Int(y);
+					writer.UInt(runLength);
+					writer.UInt(runIndex);
+					runLength = 0;
+				};
+
+			ForEachRowSpan(bounds.MinX, bounds.GetWidth(), [&](int32_t chunkX, uint32_t localX, uint32_t offset, uint32_t length)
+				{
+					const TileChunk* chunk = GetChunk(chunkX, chunkY);
+					if (!chunk || chunk->GetRowMask(localY) == 0)
+					{
+						endRun();
+						return;
+					}
+
+					const uint16_t* row = chunk->GetRow(localY) + localX;
+					for (uint32_t i = 0; i < length; i++)
+					{
+						int32_t x = bounds.MinX + static_cast<int32_t>(offset + i);
+						if (runLength > 0 && row[i] == runIndex)
+						{
+							runLength++;
+							continue;
+						}
+
+						endRun();
+						if (row[i] != TilePalette::DEFAULT_INDEX)
+						{
+							runX = x;
+							runIndex = row[i];
+							runLength = 1;
+						}
+					}
+				});
+			endRun();
+		}
+		writer.EndArray();
+		writer.EndObject();
 	}
-}
\ No newline at end of file
+
+}
@@ -1,8 +1,15 @@
 #pragma once
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "Base.h"
+#include "BitUtils.h"
 #include "Tile.h"
+#include "PackedTile.h"
+#include "TileChunk.h"
+#include "TilePalette.h"
+#include "TileRegion.h"
 #include "json.hpp"
 
 #include "Constants.h" 
@@ -70,57 +77,265 @@ namespace Tiles
         }
     }
     
+    // Half-open tile rectangle [MinX, MaxX) x [MinY, MaxY), coordinates may be negative on unbounded layers
+    struct TileBounds
+    {
+        int32_t MinX = 0;
+        int32_t MinY = 0;
+        int32_t MaxX = 0;
+        int32_t MaxY = 0;
+
+        bool IsEmpty() const { return MinX >= MaxX || MinY >= MaxY; }
+        uint32_t GetWidth() const { return IsEmpty() ? 0 : static_cast<uint32_t>(MaxX - MinX); }
+        uint32_t GetHeight() const { return IsEmpty() ? 0 : static_cast<uint32_t>(MaxY - MinY); }
+        bool Contains(int32_t x, int32_t y) const { return x >= MinX && x < MaxX && y >= MinY && y < MaxY; }
+
+        // Smallest bounds containing both, empty bounds are ignored
+        TileBounds Union(const TileBounds& other) const;
+    };
+
     class TileLayer
     {
     public:
-        TileLayer() = default;
-        TileLayer(uint32_t width, uint32_t height);
+        // Layers without a palette get a private one; LayerStack passes its shared palette
+        TileLayer() : TileLayer(0, 0) {}
+        TileLayer(uint32_t width, uint32_t height, const Ref<TilePalette>& palette = nullptr);
         ~TileLayer() = default;
 
+        // Copies share tile storage, chunks are only duplicated when one side writes to them
+        TileLayer(const TileLayer& other) = default;
+        TileLayer(TileLayer&& other) noexcept = default;
+        TileLayer& operator=(const TileLayer& other) = default;
+        TileLayer& operator=(TileLayer&& other) noexcept = default;
+
         void Clear();
         void Resize(uint32_t width, uint32_t height);
 
-        // Tile access
-        const Tile& GetTile(size_t x, size_t y) const;
-        Tile& GetTile(size_t x, size_t y);
+        // Unbounded layers accept any coordinate and allocate chunks wherever tiles are painted.
+        // Switching back to bounded drops tiles outside of [0, width) x [0, height).
+        bool IsUnbounded() const { return m_Unbounded; }
+        void SetUnbounded(bool unbounded);
+
+        // Makes the layer bounded to width x height in one step, dropping tiles outside. Loaders
+        // fill layers unbounded while their size is still unknown.
+        void SetBounded(uint32_t width, uint32_t height);
+
+        // Tile access, tiles are stored as palette indices and interned on write
+        Tile GetTile(int32_t x, int32_t y) const;
+        void SetTile(int32_t x, int32_t y, const Tile& tile);
+        void ResetTile(int32_t x, int32_t y);
+
+        const PackedTile& GetPackedTile(int32_t x, int32_t y) const;
+        void SetPackedTile(int32_t x, int32_t y, const PackedTile& tile);
+
+        uint16_t GetTileIndex(int32_t x, int32_t y) const;
+        void SetTileIndex(int32_t x, int32_t y, uint16_t tileIndex);
+
+        const Ref<TilePalette>& GetPalette() const { return m_Palette; }
+        // Re-interns every tile into palette. Returns false and leaves the layer unchanged when the
+        // palette has no room for the tiles it is missing.
+        bool SetPalette(const Ref<TilePalette>& palette);
+
+        // Replaces every palette index i with indexRemap[i], see TilePalette::RemapAtlases
+        void RemapTileIndices(const std::vector<uint16_t>& indexRemap);
 
         const std::string& GetName() const { return m_Name; }
         void SetName(const std::string& name);
 
-        uint32_t GetWidth() const { return m_Width; }
-        uint32_t GetHeight() const { return m_Height; }
+        // Change tracking. Generations come from one process-wide counter, so they only ever grow and
+        // values taken from different layers compare. A consumer remembers the generation it last
+        // processed and asks what changed since.
+        uint64_t GetGeneration() const { return m_Generation; }
+        bool HasChangedSince(uint64_t generation) const { return m_Generation > generation; }
+
+        // Generation of the last change that replaced the whole layer at once (clear, palette swap, undo snapshot)
+        uint64_t GetInvalidatedGeneration() const { return m_InvalidatedGeneration; }
+        void Invalidate();
+
+        static uint64_t NextGeneration();
+
+        // Bounded layers report their fixed size, unbounded layers the size of their painted content
+        uint32_t GetWidth() const { return GetBounds().GetWidth(); }
+        uint32_t GetHeight() const { return GetBounds().GetHeight(); }
+        TileBounds GetBounds() const;
         void SetWidth(uint32_t width);
         void SetHeight(uint32_t height);
 
         bool GetVisibility() const { return m_Visible; }
-        void SetVisibility(bool visible) { m_Visible = visible; }
+        void SetVisibility(bool visible) { m_Visible = visible; Touch(); }
 
         RenderGroup GetRenderGroup() const { return m_RenderGroup; }
-        void SetRenderGroup(RenderGroup group) { m_RenderGroup = group; }
-        void DisableRendering() { m_RenderGroup = RenderGroup::Disabled; }
+        void SetRenderGroup(RenderGroup group) { m_RenderGroup = group; Touch(); }
+        void DisableRendering() { SetRenderGroup(RenderGroup::Disabled); }
         bool IsRenderingEnabled() const { return m_RenderGroup != RenderGroup::Disabled; }
 
-        size_t GetTileCount() const { return m_Tiles.size(); }
-        bool IsEmpty() const { return m_Tiles.empty(); }
-        bool IsValidPosition(size_t x, size_t y) const { return x < m_Width && y < m_Height; }
+        size_t GetTileCount() const { return static_cast<size_t>(GetWidth()) * GetHeight(); }
+        bool IsEmpty() const { return GetTileCount() == 0; }
+        bool IsValidPosition(int32_t x, int32_t y) const;
+
+        // Painted occupancy, kept in sync by every mutator
+        size_t GetPaintedTileCount() const { return m_Storage->PaintedCount; }
+        const TileBounds& GetPaintedBounds() const;
+
+        // Column scans over allocated chunks
+        size_t CountTilesWithFlags(uint8_t flags) const;
+        size_t CountTilesUsingAtlas(size_t atlasIndex) const;
+
+        // Chunks holding tiles textured from an atlas, or only from one atlas cell when textureCoords is set.
+        // Layers whose palette has no entry for the atlas answer without touching any chunk.
+        struct ChunkUsage
+        {
+            int32_t ChunkX = 0;
+            int32_t ChunkY = 0;
+            uint32_t TileCount = 0;
+        };
+        std::vector<ChunkUsage> FindAtlasUsage(size_t atlasIndex, const glm::vec4* textureCoords = nullptr) const;
+
+        // Rectangle operations, done one contiguous row segment per chunk instead of per tile.
+        // Bounded layers clip the rectangle to the layer, unbounded layers take it as is.
+        TileRegion CopyRegion(const TileBounds& bounds) const;
+        void FillRect(const TileBounds& bounds, uint16_t tileIndex);
+        void FillRect(const TileBounds& bounds, const Tile& tile);
+
+        // Fills the tiles of one chunk whose bits are set in rowMasks, laid out like TileChunk::GetRowMask
+        void FillChunkMasked(int32_t chunkX, int32_t chunkY, const std::array<uint32_t, TileChunk::SIZE>& rowMasks, uint16_t tileIndex);
+
+        // Replaces a whole chunk with TileChunk::TILE_COUNT row-major palette indices, bounded layers
+        // drop the tiles that fall outside of the layer
+        void SetChunkTiles(int32_t chunkX, int32_t chunkY, const uint16_t* tileIndices);
+
+        // Writes count palette indices to the row starting at (x, y), clipped like FillRect
+        void SetRowTiles(int32_t x, int32_t y, uint32_t count, const uint16_t* tileIndices);
+
+        // mask is empty or holds one byte per region tile, tiles with a zero byte are left untouched
+        void PasteRegion(int32_t x, int32_t y, const TileRegion& region, const std::vector<uint8_t>& mask = {});
+
+        // Moves every tile by (dx, dy), bounded layers drop tiles that end up outside
+        void Shift(int32_t dx, int32_t dy);
+
+        // Chunk access, unallocated chunks contain only default tiles
+        size_t GetAllocatedChunkCount() const { return m_Storage->Chunks.size(); }
+
+        // Heap bytes of the tile storage. Copies share storage and chunks until written, so copies
+        // of the same layer each report the full amount.
+        size_t GetMemoryUsage() const;
+        const TileChunk* GetChunk(int32_t chunkX, int32_t chunkY) const;
 
-        auto begin() { return m_Tiles.begin(); }
-        auto end() { return m_Tiles.end(); }
-        auto begin() const { return m_Tiles.begin(); }
-        auto end() const { return m_Tiles.end(); }
+        // Calls func(chunkX, chunkY, const TileChunk&) for every allocated chunk, in no particular order
+        template<typename Func>
+        void ForEachChunk(Func&& func) const
+        {
+            for (const auto& [key, chunk] : m_Storage->Chunks)
+            {
+                func(GetChunkX(key), GetChunkY(key), *chunk);
+            }
+        }
+
+        // Calls func(chunkX, chunkY, const TileChunk* chunk) for every chunk written or freed after generation,
+        // chunk is null when it was freed. Returns false without calling func when the layer was invalidated
+        // after generation, the caller then has to rebuild from the whole layer.
+        template<typename Func>
+        bool ForEachChunkChangedSince(uint64_t generation, Func&& func) const
+        {
+            if (m_InvalidatedGeneration > generation)
+                return false;
+
+            if (m_Generation <= generation)
+                return true;
 
-        nlohmann::json ToJSON() const;
-        static TileLayer FromJSON(const nlohmann::json& jsonLayer);
+            for (const auto& [key, chunk] : m_Storage->Chunks)
+            {
+                if (chunk->GetGeneration() > generation)
+                    func(GetChunkX(key), GetChunkY(key), static_cast<const TileChunk*>(chunk.get()));
+            }
+
+            for (const auto& [key, freedGeneration] : m_Storage->FreedChunks)
+            {
+                if (freedGeneration > generation)
+                    func(GetChunkX(key), GetChunkY(key), static_cast<const TileChunk*>(nullptr));
+            }
+
+            return true;
+        }
+
+        // Calls func(x, y, const Tile&) for every painted tile, cost scales with painted tiles rather than area
+        template<typename Func>
+        void ForEachPaintedTile(Func&& func) const
+        {
+            ForEachChunk([&](int32_t chunkX, int32_t chunkY, const TileChunk& chunk)
+                {
+                    int32_t originX = chunkX * static_cast<int32_t>(TileChunk::SIZE);
+                    int32_t originY = chunkY * static_cast<int32_t>(TileChunk::SIZE);
+
+                    for (uint32_t localY = 0; localY < TileChunk::SIZE; localY++)
+                    {
+                        uint32_t mask = chunk.GetRowMask(localY);
+                        while (mask != 0)
+                        {
+                            uint32_t localX = BitUtils::CountTrailingZeros(mask);
+                            mask &= mask - 1;
+                            func(originX + static_cast<int32_t>(localX), originY + static_cast<int32_t>(localY), m_Palette->GetTile(chunk.GetTileIndex(localX, localY)));
+                        }
+                    }
+                });
+        }
+
+        // Signed chunk coordinates packed into one hash key
+        static uint64_t GetChunkKey(int32_t chunkX, int32_t chunkY) { return (static_cast<uint64_t>(static_cast<uint32_t>(chunkY)) << 32) | static_cast<uint32_t>(chunkX); }
+        static int32_t GetChunkX(uint64_t key) { return static_cast<int32_t>(static_cast<uint32_t>(key)); }
+        static int32_t GetChunkY(uint64_t key) { return static_cast<int32_t>(static_cast<uint32_t>(key >> 32)); }
+
+        void WriteJSON(JsonWriter& writer) const;
 
     private:
-        void ResizeInternal(uint32_t width, uint32_t height);
+        // Tile data shared between copies of a layer
+        struct ChunkStorage
+        {
+            std::unordered_map<uint64_t, Ref<TileChunk>> Chunks;    // Allocated chunks keyed by GetChunkKey
+            size_t PaintedCount = 0;                                // Painted tiles in the whole layer
+            std::unordered_map<uint64_t, uint64_t> FreedChunks;     // Chunk key -> generation it was freed at
+        };
+
+        // Stamps the layer with a new generation and returns it
+        uint64_t Touch() { m_Generation = NextGeneration(); return m_Generation; }
+
+        // Unshare the storage or a chunk before writing to it
+        ChunkStorage& GetMutableStorage();
+        static TileChunk& GetMutableChunk(Ref<TileChunk>& chunk);
+
+        // Drops every tile outside of [0, width) x [0, height)
+        void ClipTo(uint32_t width, uint32_t height, uint64_t generation);
+        size_t CountTilesMatching(const std::vector<uint8_t>& matches) const;
+        void UpdatePaintedBounds(int32_t x, int32_t y, int32_t paintedDelta);
+
+        // Row segment helpers for the rectangle operations, a segment may cross several chunks
+        TileBounds ClipRect(const TileBounds& bounds) const;
+        void ReadRow(int32_t x, int32_t y, uint32_t count, uint16_t* tileIndices) const;
+
+        // Calls writeChunk(TileChunk&), which returns the change in painted tiles, on the chunk after
+        // allocating or unsharing it. Chunks left empty are freed.
+        template<typename WriteChunk>
+        void UpdateChunk(uint64_t chunkKey, uint64_t generation, WriteChunk&& writeChunk);
+
+        // Calls writeSpan(TileChunk&, localX, localY, offset, length) for every chunk span of the segment
+        // that skipSpan(const TileChunk*, localX, localY, offset, length) does not reject. Returns whether
+        // anything was written.
+        template<typename SkipSpan, typename WriteSpan>
+        bool WriteRowSpans(int32_t x, int32_t y, uint32_t count, uint64_t generation, SkipSpan&& skipSpan, WriteSpan&& writeSpan);
+        bool WriteRow(int32_t x, int32_t y, uint32_t count, const uint16_t* tileIndices, const uint8_t* mask, uint64_t generation);
 
     private:
         std::string m_Name = "New Layer";                       // Display name of the layer
-        uint32_t m_Width = 0;                                   // Width in tiles
-        uint32_t m_Height = 0;                                  // Height in tiles
+        uint32_t m_Width = 0;                                   // Width in tiles, unused when unbounded
+        uint32_t m_Height = 0;                                  // Height in tiles, unused when unbounded
+        bool m_Unbounded = false;                               // Whether tiles may be painted at any coordinate
         bool m_Visible = true;                                  // Whether layer is visible in editor/game
         RenderGroup m_RenderGroup = RenderGroup::Background;    // Rendering order group
-        std::vector<Tile> m_Tiles;                              // Flat array of tiles (row-major order)
+        Ref<TilePalette> m_Palette;                             // Tile variants referenced by the chunks
+        Ref<ChunkStorage> m_Storage;                            // Copy-on-write tile storage
+        mutable TileBounds m_PaintedBounds;                     // Tight bounds of painted tiles
+        mutable bool m_PaintedBoundsDirty = false;              // Bounds shrank and must be recomputed on next query
+        uint64_t m_Generation = 0;                              // Generation of the last change of any kind
+        uint64_t m_InvalidatedGeneration = 0;                   // Generation of the last whole-layer change
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,217 @@
+#include "TilePalette.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Lumina/Core/Log.h"
+
+namespace Tiles
+{
+    TilePalette::TilePalette()
+    {
+        Append(PackedTile());
+    }
+
+    bool TilePalette::Intern(const PackedTile& tile, uint16_t& index)
+    {
+        if (Find(tile, index))
+            return true;
+
+        if (m_Tiles.size() >= MAX_ENTRY_COUNT)
+        {
+            LUMINA_LOG_INFO("TilePalette::Intern: Palette is full ({} entries), tile not added", MAX_ENTRY_COUNT);
+            return false;
+        }
+
+        index = Append(tile);
+        return true;
+    }
+
+    bool TilePalette::Find(const PackedTile& tile, uint16_t& index) const
+    {
+        auto it = m_Lookup.find(tile);
+        if (it == m_Lookup.end())
+            return false;
+
+        index = it->second;
+        return true;
+    }
+
+    uint16_t TilePalette::Append(const PackedTile& tile)
+    {
+        uint16_t index = static_cast<uint16_t>(m_Tiles.size());
+
+        m_PackedTiles.push_back(tile);
+        m_Tiles.push_back(tile.ToTile());
+        m_Flags.push_back(tile.Flags);
+        m_AtlasIndices.push_back(tile.AtlasIndex);
+        m_Tints.push_back(tile.Tint);
+        m_Lookup.emplace(tile, index);
+        AddAtlasEntry(index);
+
+        return index;
+    }
+
+    const std::vector<uint16_t>& TilePalette::GetEntriesUsingAtlas(size_t atlasIndex) const
+    {
+        static const std::vector<uint16_t> s_NoEntries;
+        return atlasIndex < m_AtlasEntries.size() ? m_AtlasEntries[atlasIndex] : s_NoEntries;
+    }
+
+    std::vector<uint8_t> TilePalette::GetAtlasMatches(size_t atlasIndex, const glm::vec4* textureCoords) const
+    {
+        const std::vector<uint16_t>& entries = GetEntriesUsingAtlas(atlasIndex);
+
+        // Compare cells in packed form so coordinates match the way tiles were interned
+        PackedTile cell;
+        if (textureCoords)
+        {
+            Tile probe;
+            probe.SetPainted(true);
+            probe.SetTextureCoords(*textureCoords);
+            cell = PackedTile::FromTile(probe);
+        }
+
+        std::vector<uint8_t> matches;
+        for (uint16_t index : entries)
+        {
+            const PackedTile& tile = m_PackedTiles[index];
+            if (textureCoords && !std::equal(std::begin(tile.TextureCoords), std::end(tile.TextureCoords), std::begin(cell.TextureCoords)))
+                continue;
+
+            if (matches.empty())
+                matches.resize(m_PackedTiles.size(), 0);
+            matches[index] = 1;
+        }
+        return matches;
+    }
+
+    std::vector<uint16_t> TilePalette::RemapAtlases(const std::vector<int32_t>& atlasRemap)
+    {
+        std::vector<std::vector<uint16_t>> previousEntries;
+        previousEntries.swap(m_AtlasEntries);
+
+        // Every entry is rewritten before any lookup, an entry moving into the place of another
+        // atlas (a swap) must not be merged with the entry about to move out of it
+        std::vector<uint16_t> changedEntries;
+        for (size_t atlasIndex = 0; atlasIndex < previousEntries.size(); atlasIndex++)
+        {
+            int32_t newAtlasIndex = atlasIndex < atlasRemap.size() ? atlasRemap[atlasIndex] : static_cast<int32_t>(atlasIndex);
+
+            for (uint16_t index : previousEntries[atlasIndex])
+            {
+                if (newAtlasIndex == static_cast<int32_t>(atlasIndex))
+                {
+                    AddAtlasEntry(index);
+                    continue;
+                }
+
+                auto it = m_Lookup.find(m_PackedTiles[index]);
+                if (it != m_Lookup.end() && it->second == index)
+                    m_Lookup.erase(it);
+
+                PackedTile tile = m_PackedTiles[index];
+                if (newAtlasIndex < 0 || newAtlasIndex >= PackedTile::INVALID_ATLAS_INDEX)
+                {
+                    // Same packed form FromTile gives an untextured tile, so it interns like one
+                    PackedTile untextured;
+                    std::copy(std::begin(untextured.TextureCoords), std::end(untextured.TextureCoords), std::begin(tile.TextureCoords));
+                    tile.AtlasIndex = PackedTile::INVALID_ATLAS_INDEX;
+                    tile.Flags &= ~PackedTile::FLAG_TEXTURED;
+                }
+                else
+                {
+                    tile.AtlasIndex = static_cast<uint8_t>(newAtlasIndex);
+                }
+
+                m_PackedTiles[index] = tile;
+                m_Tiles[index] = tile.ToTile();
+                m_Flags[index] = tile.Flags;
+                m_AtlasIndices[index] = tile.AtlasIndex;
+                m_Tints[index] = tile.Tint;
+                AddAtlasEntry(index);
+                changedEntries.push_back(index);
+            }
+        }
+
+        for (auto& entries : m_AtlasEntries)
+        {
+            std::sort(entries.begin(), entries.end());
+        }
+
+        // Rewritten entries equal to an entry already in the lookup merge into it, ties go to the lower index
+        std::sort(changedEntries.begin(), changedEntries.end());
+        std::vector<uint16_t> indexRemap;
+        for (uint16_t index : changedEntries)
+        {
+            auto [it, inserted] = m_Lookup.emplace(m_PackedTiles[index], index);
+            if (inserted)
+                continue;
+
+            if (it->second > index)
+            {
+                // An unchanged entry with a higher index, the rewritten one takes over the lookup
+                std::swap(index, it->second);
+            }
+
+            if (indexRemap.empty())
+            {
+                indexRemap.resize(m_Tiles.size());
+                for (size_t i = 0; i < indexRemap.size(); i++)
+                {
+                    indexRemap[i] = static_cast<uint16_t>(i);
+                }
+            }
+            indexRemap[index] = it->second;
+        }
+
+        if (!indexRemap.empty())
+        {
+            LUMINA_LOG_INFO("TilePalette::RemapAtlases: Merged palette entries that became equal");
+        }
+        return indexRemap;
+    }
+
+    void TilePalette::AddAtlasEntry(uint16_t index)
+    {
+        uint8_t atlasIndex = m_AtlasIndices[index];
+        if (atlasIndex == PackedTile::INVALID_ATLAS_INDEX)
+            return;
+
+        if (atlasIndex >= m_AtlasEntries.size())
+            m_AtlasEntries.resize(atlasIndex + 1);
+
+        m_AtlasEntries[atlasIndex].push_back(index);
+    }
+
+    void TilePalette::WriteJSON(JsonWriter& writer) const
+    {
+        // Entry 0 is implicit, entry i is stored at array position i - 1
+        writer.BeginArray();
+        for (size_t i = 1; i < m_Tiles.size(); i++)
+        {
+            m_Tiles[i].WriteJSON(writer);
+        }
+        writer.EndArray();
+    }
+
+
+    Ref<TilePalette> TilePalette::FromPackedTiles(const PackedTile* tiles, size_t count)
+    {
+        Ref<TilePalette> palette = CreateRef<TilePalette>();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (palette->m_Tiles.size() >= MAX_ENTRY_COUNT)
+            {
+                LUMINA_LOG_INFO("TilePalette::FromPackedTiles: Palette has more than {} entries, ignoring the rest", MAX_ENTRY_COUNT);
+                break;
+            }
+
+            // Round trip through Tile so entries read from a file are in canonical form
+            palette->Append(PackedTile::FromTile(tiles[i].ToTile()));
+        }
+
+        return palette;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Base.h"
+#include "ColumnSpan.h"
+#include "PackedTile.h"
+#include "Tile.h"
+
+#include "json.hpp"
+
+namespace Tiles
+{
+    // Interned set of every distinct tile variant used by a layer stack. Layers store 16 bit
+    // palette indices instead of tiles, so tile equality anywhere in the editor is an integer
+    // compare. Lookup goes through the canonical PackedTile form, the same one Tile::operator==
+    // and std::hash<Tile> use, so tiles that quantize to the same value share one entry.
+    //
+    // The palette is append-only: an index stays valid for the lifetime of the palette, which
+    // lets undo history and layer snapshots keep raw indices.
+    class TilePalette
+    {
+    public:
+        static constexpr uint16_t DEFAULT_INDEX = 0;                   // Always the default (unpainted) tile
+        static constexpr size_t MAX_ENTRY_COUNT = size_t(UINT16_MAX) + 1;
+
+        TilePalette();
+        ~TilePalette() = default;
+
+        // Sets index to the entry of the tile, adding it to the palette if it is new. Returns false
+        // when the tile is new and the palette is full, callers then leave their target unchanged.
+        bool Intern(const PackedTile& tile, uint16_t& index);
+        bool Intern(const Tile& tile, uint16_t& index) { return Intern(PackedTile::FromTile(tile), index); }
+
+        // Like Intern, but never adds an entry
+        bool Find(const PackedTile& tile, uint16_t& index) const;
+
+        const PackedTile& GetPackedTile(uint16_t index) const { return m_PackedTiles[index]; }
+        const Tile& GetTile(uint16_t index) const { return m_Tiles[index]; }
+
+        size_t GetEntryCount() const { return m_Tiles.size(); }
+        bool IsValidIndex(size_t index) const { return index < m_Tiles.size(); }
+
+        // Entries that reference an atlas, kept up to date as entries are added or remapped
+        const std::vector<uint16_t>& GetEntriesUsingAtlas(size_t atlasIndex) const;
+
+        // One byte per entry, set for entries using the atlas (and only the given atlas cell when
+        // textureCoords is set). Empty when no entry matches, so callers can skip their scan.
+        std::vector<uint8_t> GetAtlasMatches(size_t atlasIndex, const glm::vec4* textureCoords = nullptr) const;
+
+        // Points every entry at atlasRemap[atlasIndex], atlases past the end of atlasRemap keep their index.
+        // Entries whose atlas maps to a negative value lose their texture but stay painted. Only entries
+        // of remapped atlases are touched.
+        //
+        // Entries that end up equal to another entry (two cells of a removed atlas both losing their
+        // texture) are merged into the lower index, so one tile keeps one index. Returns the index
+        // remap layers have to apply, empty when nothing was merged. Merged entries stay in the palette
+        // and follow later remaps like their twin, so indices kept by undo history still render right.
+        std::vector<uint16_t> RemapAtlases(const std::vector<int32_t>& atlasRemap);
+
+        // Read-only attribute columns, indexed by palette index
+        ColumnSpan<const uint8_t> GetFlags() const { return { m_Flags.data(), m_Flags.size() }; }
+        ColumnSpan<const uint8_t> GetAtlasIndices() const { return { m_AtlasIndices.data(), m_AtlasIndices.size() }; }
+        ColumnSpan<const uint32_t> GetTints() const { return { m_Tints.data(), m_Tints.size() }; }
+
+        void WriteJSON(JsonWriter& writer) const;
+
+        // Rebuilds a palette from entries 1 onward in packed form, see ProjectFile
+        static Ref<TilePalette> FromPackedTiles(const PackedTile* tiles, size_t count);
+
+    private:
+        friend class ProjectJSONReader;
+
+        uint16_t Append(const PackedTile& tile);
+        void AddAtlasEntry(uint16_t index);
+
+    private:
+        std::vector<PackedTile> m_PackedTiles;                          // Canonical packed form of each entry
+        std::vector<Tile> m_Tiles;                                      // Decoded entries, so readers never unpack
+        std::vector<uint8_t> m_Flags;                                   // PackedTile::Flags column
+        std::vector<uint8_t> m_AtlasIndices;                            // PackedTile::AtlasIndex column
+        std::vector<uint32_t> m_Tints;                                  // PackedTile::Tint column
+        std::unordered_map<PackedTile, uint16_t> m_Lookup;              // Packed tile to palette index
+        std::vector<std::vector<uint16_t>> m_AtlasEntries;              // Atlas index to the entries referencing it
+    };
+}
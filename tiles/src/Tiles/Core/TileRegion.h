@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Base.h"
+#include "TilePalette.h"
+
+namespace Tiles
+{
+    // Rectangular block of palette indices copied out of a layer, rows stored back to back.
+    // The region keeps the palette its indices refer to, so it can be pasted into a layer
+    // with a different palette.
+    class TileRegion
+    {
+    public:
+        TileRegion() = default;
+        TileRegion(uint32_t width, uint32_t height, const Ref<TilePalette>& palette)
+            : m_Width(width), m_Height(height), m_Palette(palette), m_TileIndices(static_cast<size_t>(width) * height, TilePalette::DEFAULT_INDEX) {}
+
+        uint32_t GetWidth() const { return m_Width; }
+        uint32_t GetHeight() const { return m_Height; }
+        size_t GetTileCount() const { return m_TileIndices.size(); }
+        bool IsEmpty() const { return m_TileIndices.empty(); }
+
+        const Ref<TilePalette>& GetPalette() const { return m_Palette; }
+
+        uint16_t GetTileIndex(uint32_t x, uint32_t y) const { return m_TileIndices[GetIndex(x, y)]; }
+        void SetTileIndex(uint32_t x, uint32_t y, uint16_t tileIndex) { m_TileIndices[GetIndex(x, y)] = tileIndex; }
+
+        uint16_t* GetRow(uint32_t y) { return m_TileIndices.data() + GetIndex(0, y); }
+        const uint16_t* GetRow(uint32_t y) const { return m_TileIndices.data() + GetIndex(0, y); }
+
+        size_t GetIndex(uint32_t x, uint32_t y) const { return static_cast<size_t>(y) * m_Width + x; }
+
+    private:
+        uint32_t m_Width = 0;                       // Width in tiles
+        uint32_t m_Height = 0;                      // Height in tiles
+        Ref<TilePalette> m_Palette;                 // Palette the indices refer to
+        std::vector<uint16_t> m_TileIndices;        // Row-major palette indices
+    };
+}
@@ -0,0 +1,116 @@
+#include "WorkerPool.h"
+
+namespace Tiles
+{
+    namespace
+    {
+        // Lets nested ParallelFor calls fall back to a plain loop instead of deadlocking
+        thread_local bool s_InsideJob = false;
+    }
+
+    WorkerPool::WorkerPool(size_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            size_t hardwareThreads = std::thread::hardware_concurrency();
+            threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+
+        m_Workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            m_Workers.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_JobAvailable.notify_all();
+
+        for (std::thread& worker : m_Workers)
+        {
+            worker.join();
+        }
+    }
+
+    void WorkerPool::ParallelFor(size_t count, const std::function<void(size_t)>& func)
+    {
+        if (count == 0)
+            return;
+
+        if (count == 1 || m_Workers.empty() || s_InsideJob)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> submitLock(m_SubmitMutex);
+
+        Ref<Job> job = CreateRef<Job>(func, count);
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Job = job;
+            m_JobGeneration++;
+        }
+        m_JobAvailable.notify_all();
+
+        RunJob(*job);
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_JobFinished.wait(lock, [&job]() { return job->Remaining.load() == 0; });
+    }
+
+    WorkerPool& WorkerPool::Get()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    void WorkerPool::WorkerLoop()
+    {
+        uint64_t lastGeneration = 0;
+
+        while (true)
+        {
+            Ref<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_JobAvailable.wait(lock, [&]() { return m_Stopping || m_JobGeneration != lastGeneration; });
+
+                if (m_Stopping)
+                    return;
+
+                job = m_Job;
+                lastGeneration = m_JobGeneration;
+            }
+
+            RunJob(*job);
+        }
+    }
+
+    void WorkerPool::RunJob(Job& job)
+    {
+        s_InsideJob = true;
+
+        size_t index;
+        while ((index = job.Next.fetch_add(1)) < job.Count)
+        {
+            job.Func(index);
+
+            if (job.Remaining.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_JobFinished.notify_all();
+            }
+        }
+
+        s_InsideJob = false;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Base.h"
+
+namespace Tiles
+{
+    // Fixed set of worker threads for splitting editor operations across cores. Work is handed
+    // out one index at a time, so uneven items (a dense layer next to an empty one) balance
+    // themselves. The calling thread takes part in every job and blocks until it is finished.
+    class WorkerPool
+    {
+    public:
+        // Zero picks one worker per hardware thread, minus the calling thread
+        explicit WorkerPool(size_t threadCount = 0);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        // Runs func(i) for every i in [0, count). Calls from inside a job run inline.
+        void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+        size_t GetThreadCount() const { return m_Workers.size(); }
+
+        // Pool shared by the whole editor, created on first use
+        static WorkerPool& Get();
+
+    private:
+        struct Job
+        {
+            Job(const std::function<void(size_t)>& func, size_t count) : Func(func), Count(count), Remaining(count) {}
+
+            const std::function<void(size_t)>& Func;    // Only called while the job is unfinished
+            size_t Count;                               // Number of indices in the job
+            std::atomic<size_t> Next = 0;               // Next index to hand out
+            std::atomic<size_t> Remaining;              // Indices not yet finished
+        };
+
+        void WorkerLoop();
+        void RunJob(Job& job);
+
+    private:
+        std::vector<std::thread> m_Workers;             // Threads waiting for jobs
+        std::mutex m_Mutex;                             // Guards m_Job and m_Stopping
+        std::mutex m_SubmitMutex;                       // Serializes ParallelFor calls from different threads
+        std::condition_variable m_JobAvailable;         // Wakes workers when a job is posted
+        std::condition_variable m_JobFinished;          // Wakes the caller when the last index is done
+        Ref<Job> m_Job;                                 // Current or most recent job
+        uint64_t m_JobGeneration = 0;                   // Incremented for every posted job
+        bool m_Stopping = false;                        // Set on destruction
+    };
+}
@@ -1,6 +1,7 @@
 #include "PanelBrushAttributes.h"
 
 #include "Core/Constants.h"
+#include "Core/PackedTile.h"
 
 namespace Tiles
 {
@@ -31,6 +32,8 @@ namespace Tiles
 
         ImGui::PushID("BrushAttributes");
 
+        SnapBrush();
+
         RenderSectionRotation();
         RenderSectionSize();
         RenderSectionTint();
@@ -40,25 +43,45 @@ namespace Tiles
         ImGui::PopStyleVar();
     }
 
+    void PanelBrushAttributes::SnapBrush()
+    {
+        // Painted tiles only keep what PackedTile stores, the brush shows the same so the preview matches
+        auto& brush = m_Context->GetBrush();
+        if (!brush.IsPainted())
+            return;
+
+        Tile packed = PackedTile::FromTile(brush).ToTile();
+        brush.SetRotation(packed.GetRotation());
+        brush.SetSize(packed.GetSize());
+    }
+
     void PanelBrushAttributes::RenderSectionRotation()
     {
         auto& brush = m_Context->GetBrush();
-        auto rotation = brush.GetRotation();
+        glm::vec3 rotation = brush.GetRotation();
 
         RenderComponentTitle("Rotation");
 
-        RenderComponentVec3Controls("Rotation", rotation,
-            Brush::Rotation::Min, Brush::Rotation::Max, "%.1f\u00B0");
+        // Tiles turn half way around X and Y and in quarter turns around Z
+        ImGui::PushStyleVar(ImGuiStyleVar_CellPadding, ImVec2(UI::Component::SpaceBetween / 2.0f, 0.0f));
+        ImGuiTableFlags tableFlags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_NoHostExtendX;
 
-        // Update brush if rotation changed
-        if (rotation.x != brush.GetRotation().x || rotation.y != brush.GetRotation().y || rotation.z != brush.GetRotation().z)
+        if (ImGui::BeginTable("##RotationFlips", 2, tableFlags))
         {
-            brush.SetRotation(rotation);
-        }
+            ImGui::TableSetupColumn("FlipX", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("FlipY", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableNextRow();
 
-        // Render preset buttons in a table
-        ImGui::PushStyleVar(ImGuiStyleVar_CellPadding, ImVec2(UI::Component::SpaceBetween / 2.0f, 0.0f));
-        ImGuiTableFlags tableFlags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_NoHostExtendX;
+            ImGui::TableNextColumn();
+            if (RenderComponentButton("FlipX", "X 180\u00B0", rotation.x != 0.0f ? UI::Color::ButtonActive : UI::Color::Button))
+                brush.SetRotation(glm::vec3(rotation.x != 0.0f ? Brush::Rotation::Zero : Brush::Rotation::Half, rotation.y, rotation.z));
+
+            ImGui::TableNextColumn();
+            if (RenderComponentButton("FlipY", "Y 180\u00B0", rotation.y != 0.0f ? UI::Color::ButtonActive : UI::Color::Button))
+                brush.SetRotation(glm::vec3(rotation.x, rotation.y != 0.0f ? Brush::Rotation::Zero : Brush::Rotation::Half, rotation.z));
+
+            ImGui::EndTable();
+        }
 
         if (ImGui::BeginTable("##RotationPresets", 4, tableFlags))
         {
@@ -69,20 +92,20 @@ namespace Tiles
             ImGui::TableNextRow();
 
             ImGui::TableNextColumn();
-            if (RenderComponentButton("Rot0", "0\u00B0", UI::Color::Button))
-                brush.SetRotation(glm::vec3(0.0f, 0.0f, Brush::Rotation::Zero));
+            if (RenderComponentButton("Rot0", "0\u00B0", rotation.z == Brush::Rotation::Zero ? UI::Color::ButtonActive : UI::Color::Button))
+                brush.SetRotation(glm::vec3(rotation.x, rotation.y, Brush::Rotation::Zero));
 
             ImGui::TableNextColumn();
-            if (RenderComponentButton("Rot90", "90\u00B0", UI::Color::Button))
-                brush.SetRotation(glm::vec3(0.0f, 0.0f, Brush::Rotation::Quarter));
+            if (RenderComponentButton("Rot90", "90\u00B0", rotation.z == Brush::Rotation::Quarter ? UI::Color::ButtonActive : UI::Color::Button))
+                brush.SetRotation(glm::vec3(rotation.x, rotation.y, Brush::Rotation::Quarter));
 
             ImGui::TableNextColumn();
-            if (RenderComponentButton("Rot180", "180\u00B0", UI::Color::Button))
-                brush.SetRotation(glm::vec3(0.0f, 0.0f, Brush::Rotation::Half));
+            if (RenderComponentButton("Rot180", "180\u00B0", rotation.z == Brush::Rotation::Half ? UI::Color::ButtonActive : UI::Color::Button))
+                brush.SetRotation(glm::vec3(rotation.x, rotation.y, Brush::Rotation::Half));
 
             ImGui::TableNextColumn();
-            if (RenderComponentButton("Rot270", "270\u00B0", UI::Color::Button))
-                brush.SetRotation(glm::vec3(0.0f, 0.0f, Brush::Rotation::ThreeQuarter));
+            if (RenderComponentButton("Rot270", "270\u00B0", rotation.z == Brush::Rotation::ThreeQuarter ? UI::Color::ButtonActive : UI::Color::Button))
+                brush.SetRotation(glm::vec3(rotation.x, rotation.y, Brush::Rotation::ThreeQuarter));
 
             ImGui::EndTable();
         }
@@ -101,10 +124,10 @@ namespace Tiles
         RenderComponentVec2Controls("Size", size,
             Brush::Size::Min, Brush::Size::Max, "%.2f", "W", "H");
 
-        // Update brush if size changed
+        // Update brush if size changed, in the steps a painted tile stores
         if (size.x != brush.GetSize().x || size.y != brush.GetSize().y)
         {
-            brush.SetSize(size);
+            brush.SetSize(glm::round(size * PackedTile::SIZE_SCALE) / PackedTile::SIZE_SCALE);
         }
 
         // Render preset buttons in a table
@@ -298,62 +321,6 @@ namespace Tiles
         ImGui::Spacing();
     }
 
-    void PanelBrushAttributes::RenderComponentVec3Controls(const char* id, glm::vec3& vec, float minVal, float maxVal, const char* format, const char* xName, const char* yName, const char* zName)
-    {
-        // Define ID strings at the top
-        std::string tableId = std::string("##") + id + "Table";
-        std::string colXId = std::string(id) + "X";
-        std::string colYId = std::string(id) + "Y";
-        std::string colZId = std::string(id) + "Z";
-        std::string labelXId = std::string(id) + "LabelX";
-        std::string dragXId = std::string(id) + "DragX";
-        std::string labelYId = std::string(id) + "LabelY";
-        std::string dragYId = std::string(id) + "DragY";
-        std::string labelZId = std::string(id) + "LabelZ";
-        std::string dragZId = std::string(id) + "DragZ";
-
-        float framePaddingY = (UI::Component::ButtonHeight - ImGui::GetTextLineHeight()) * 0.5f;
-        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(UI::Component::FramePadding, framePaddingY));
-        ImGui::PushStyleVar(ImGuiStyleVar_CellPadding, ImVec2(0.0f, 0.0f));
-
-        ImGuiTableFlags tableFlags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_NoHostExtendX;
-
-        if (ImGui::BeginTable(tableId.c_str(), 3, tableFlags))
-        {
-            ImGui::TableSetupColumn(colXId.c_str(), ImGuiTableColumnFlags_WidthStretch);
-            ImGui::TableSetupColumn(colYId.c_str(), ImGuiTableColumnFlags_WidthStretch);
-            ImGui::TableSetupColumn(colZId.c_str(), ImGuiTableColumnFlags_WidthStretch);
-            ImGui::TableNextRow();
-
-            // X component
-            ImGui::TableNextColumn();
-            RenderComponentLabel(labelXId.c_str(), xName, UI::Color::Red);
-            ImGui::SameLine(0, UI::Component::SpaceBetween);
-            RenderComponentDragFloat(dragXId.c_str(), &vec.x, 1.0f, minVal, maxVal, format);
-
-            // Y component
-            ImGui::TableNextColumn();
-            ImGui::Dummy(ImVec2(UI::Component::SpaceBetween, 0));
-            ImGui::SameLine(0, 0);
-            RenderComponentLabel(labelYId.c_str(), yName, UI::Color::Green);
-            ImGui::SameLine(0, UI::Component::SpaceBetween);
-            RenderComponentDragFloat(dragYId.c_str(), &vec.y, 1.0f, minVal, maxVal, format);
-
-            // Z component
-            ImGui::TableNextColumn();
-            ImGui::Dummy(ImVec2(UI::Component::SpaceBetween, 0));
-            ImGui::SameLine(0, 0);
-            RenderComponentLabel(labelZId.c_str(), zName, UI::Color::Blue);
-            ImGui::SameLine(0, UI::Component::SpaceBetween);
-            RenderComponentDragFloat(dragZId.c_str(), &vec.z, 1.0f, minVal, maxVal, format);
-
-            ImGui::EndTable();
-        }
-
-        ImGui::PopStyleVar(2);
-        ImGui::Spacing();
-    }
-
     void PanelBrushAttributes::RenderComponentVec4Controls(const char* id, glm::vec4& vec, float minVal, float maxVal, const char* format, const char* xName, const char* yName, const char* zName, const char* wName)
     {
         // Define ID strings at the top
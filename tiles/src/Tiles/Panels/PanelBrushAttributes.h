@@ -18,6 +18,7 @@ namespace Tiles
 
     private:
         void RenderBlockBrushAttributes();
+        void SnapBrush();
 
         void RenderSectionRotation();
         void RenderSectionSize();
@@ -26,7 +27,6 @@ namespace Tiles
 
         void RenderComponentTitle(const char* title);
         void RenderComponentVec2Controls(const char* id, glm::vec2& vec, float minVal, float maxVal, const char* format = "%.3f", const char* xName = "X", const char* yName = "Y");
-        void RenderComponentVec3Controls(const char* id, glm::vec3& vec, float minVal, float maxVal, const char* format = "%.3f", const char* xName = "X", const char* yName = "Y", const char* zName = "Z");
         void RenderComponentVec4Controls(const char* id, glm::vec4& vec, float minVal, float maxVal, const char* format = "%.3f", const char* xName = "X", const char* yName = "Y", const char* zName = "Z", const char* wName = "W");
         void RenderComponentLabel(const char* id, const char* label, const ImVec4& color);
         void RenderComponentDragFloat(const char* id, float* value, float speed, float minVal, float maxVal, const char* format = "%.3f");
@@ -110,6 +110,8 @@ namespace Tiles
 
         ImGui::Text("Dimensions: %d x %d", layerStack.GetWidth(), layerStack.GetHeight());
         ImGui::Text("Layer Count: %zu", layerStack.GetLayerCount());
+        ImGui::Text("Palette Entries: %zu", layerStack.GetPalette()->GetEntryCount());
+        ImGui::Text("Generation: %llu", static_cast<unsigned long long>(layerStack.GetGeneration()));
         ImGui::Text("Is Empty: %s", layerStack.IsEmpty() ? "Yes" : "No");
 
         if (layerStack.GetLayerCount() > 0)
@@ -130,14 +132,12 @@ namespace Tiles
                     ImGui::Text("  Rendering Enabled: %s", layer.IsRenderingEnabled() ? "Yes" : "No");
                     ImGui::Text("  Tile Count: %zu", layer.GetTileCount());
                     ImGui::Text("  Is Empty: %s", layer.IsEmpty() ? "Yes" : "No");
+                    ImGui::Text("  Allocated Chunks: %zu", layer.GetAllocatedChunkCount());
+                    ImGui::Text("  Generation: %llu", static_cast<unsigned long long>(layer.GetGeneration()));
 
-                    // Count painted tiles
-                    size_t paintedTiles = 0;
-                    for (const auto& tile : layer)
-                    {
-                        if (tile.IsPainted()) paintedTiles++;
-                    }
-                    ImGui::Text("  Painted Tiles: %zu", paintedTiles);
+                    ImGui::Text("  Painted Tiles: %zu", layer.GetPaintedTileCount());
+                    const TileBounds& paintedBounds = layer.GetPaintedBounds();
+                    ImGui::Text("  Painted Bounds: (%d, %d) - (%d, %d)", paintedBounds.MinX, paintedBounds.MinY, paintedBounds.MaxX, paintedBounds.MaxY);
 
                     ImGui::TreePop();
                 }
@@ -161,13 +161,9 @@ namespace Tiles
             ImGui::Text("  Render Group: %d", workingLayer.GetRenderGroup());
             ImGui::Text("  Tile Count: %zu", workingLayer.GetTileCount());
 
-            // Count painted tiles in working layer
-            size_t paintedTiles = 0;
-            for (const auto& tile : workingLayer)
-            {
-                if (tile.IsPainted()) paintedTiles++;
-            }
-            ImGui::Text("  Painted Tiles: %zu", paintedTiles);
+            ImGui::Text("  Painted Tiles: %zu", workingLayer.GetPaintedTileCount());
+            const TileBounds& paintedBounds = workingLayer.GetPaintedBounds();
+            ImGui::Text("  Painted Bounds: (%d, %d) - (%d, %d)", paintedBounds.MinX, paintedBounds.MinY, paintedBounds.MaxX, paintedBounds.MaxY);
         }
     }
 
@@ -202,6 +198,14 @@ namespace Tiles
         ImGui::Text("Can Undo: %s", m_Context->CanUndo() ? "Yes" : "No");
         ImGui::Text("Can Redo: %s", m_Context->CanRedo() ? "Yes" : "No");
 
+        const CommandHistory& history = m_Context->GetCommandHistory();
+        constexpr double megabyte = 1024.0 * 1024.0;
+        ImGui::Text("Undo Entries: %zu (%.2f MB)", history.GetUndoCount(), history.GetUndoMemoryUsage() / megabyte);
+        ImGui::Text("Redo Entries: %zu (%.2f MB)", history.GetRedoCount(), history.GetRedoMemoryUsage() / megabyte);
+        ImGui::Text("Memory: %.2f / %.2f MB", history.GetMemoryUsage() / megabyte, history.GetMemoryBudget() / megabyte);
+        ImGui::Text("Packed Entries: %zu", history.GetPackedCount());
+        ImGui::Text("Spilled Entries: %zu (%.2f / %.2f MB on disk)", history.GetSpilledCount(), history.GetSpilledBytes() / megabyte, history.GetSpillFileSize() / megabyte);
+
         if (ImGui::Button("Clear History"))
         {
             m_Context->ClearHistory();
@@ -211,8 +215,24 @@ namespace Tiles
     void PanelDebug::RenderTextureAtlasInfo()
     {
         auto& project = m_Context->GetProject();
+        const auto& layerStack = project->GetLayerStack();
         ImGui::Text("Atlas Count: %zu", project->GetTextureAtlasCount());
 
+        // Counting scans every chunk of every layer, so it only runs again once the layers change
+        uint64_t generation = layerStack.GetGeneration();
+        if (m_AtlasCountsLayerStack != &layerStack || m_AtlasCountsGeneration != generation ||
+            m_AtlasTileCounts.size() != project->GetTextureAtlasCount())
+        {
+            m_AtlasCountsLayerStack = &layerStack;
+            m_AtlasCountsGeneration = generation;
+            m_AtlasTileCounts.assign(project->GetTextureAtlasCount(), 0);
+            for (size_t i = 0; i < m_AtlasTileCounts.size(); ++i)
+            {
+                for (size_t layerIndex = 0; layerIndex < layerStack.GetLayerCount(); ++layerIndex)
+                    m_AtlasTileCounts[i] += layerStack.GetLayer(layerIndex).CountTilesUsingAtlas(i);
+            }
+        }
+
         if (project->GetTextureAtlasCount() > 0)
         {
             ImGui::Separator();
@@ -221,8 +241,7 @@ namespace Tiles
                 auto atlas = project->GetTextureAtlas(i);
                 if (atlas)
                 {
-                    ImGui::Text("Atlas %zu: Valid", i);
-                    // Add more atlas-specific info if TextureAtlas has accessible properties
+                    ImGui::Text("Atlas %zu: Valid (%zu tiles)", i, m_AtlasTileCounts[i]);
                 }
                 else
                 {
@@ -245,13 +264,15 @@ namespace Tiles
         const auto& layerStack = project->GetLayerStack();
 
         size_t totalTiles = 0;
+        size_t totalChunks = 0;
         for (size_t i = 0; i < layerStack.GetLayerCount(); ++i)
         {
             totalTiles += layerStack.GetLayer(i).GetTileCount();
+            totalChunks += layerStack.GetLayer(i).GetAllocatedChunkCount();
         }
 
-        size_t tileMemory = totalTiles * sizeof(Tile);
-        ImGui::Text("  Tiles: %zu (%zu bytes)", totalTiles, tileMemory);
+        size_t tileMemory = totalChunks * sizeof(TileChunk);
+        ImGui::Text("  Tiles: %zu (%zu chunks, %zu bytes)", totalTiles, totalChunks, tileMemory);
         ImGui::Text("  Layers: %zu", layerStack.GetLayerCount());
         ImGui::Text("  Atlases: %zu", project->GetTextureAtlasCount());
     }
@@ -37,5 +37,10 @@ namespace Tiles
         float m_UpdateTime = 0.0f;
         float m_RenderTime = 0.0f;
         std::chrono::steady_clock::time_point m_LastUpdateTime;
+
+        // Tiles per atlas, recounted when the layer stack generation changes
+        const LayerStack* m_AtlasCountsLayerStack = nullptr;
+        uint64_t m_AtlasCountsGeneration = 0;
+        std::vector<size_t> m_AtlasTileCounts;
     };
 }
\ No newline at end of file
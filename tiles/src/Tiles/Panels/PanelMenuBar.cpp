@@ -54,6 +54,11 @@ namespace Tiles
             ShowAboutDialog();
         }
 
+        if (m_ShowExportResultDialog)
+        {
+            ShowExportResultDialog();
+        }
+
         m_PopupSaveAs.Render();
         m_PopupOpenProject.Render();
 
@@ -88,7 +93,7 @@ namespace Tiles
             else if (ImGui::IsKeyPressed(ImGuiKey_S, false))
             {
                 auto project = m_Context->GetProject();
-                if (project->IsNew() && project->HasUnsavedChanges())
+                if ((project->IsNew() && project->HasUnsavedChanges()) || m_Context->NeedsSaveAs())
                 {
                     m_PopupSaveAs.Toggle();
                 }
@@ -135,7 +140,7 @@ namespace Tiles
             if (ImGui::MenuItem("Save", "Ctrl+S", false, hasProject))
             {
                 auto project = m_Context->GetProject();
-                if (project->IsNew() && project->HasUnsavedChanges())
+                if ((project->IsNew() && project->HasUnsavedChanges()) || m_Context->NeedsSaveAs())
                 {
                     m_PopupSaveAs.Show();
                 }
@@ -157,6 +162,22 @@ namespace Tiles
                 m_PopupRenderMatrix.Show(); 
             }
 
+            // Written next to the project file, with the JSON extension
+            bool hasProjectFile = hasProject && !m_Context->GetProject()->IsNew();
+            if (ImGui::BeginMenu("Export JSON", hasProjectFile))
+            {
+                bool compact = ImGui::MenuItem("Compact");
+                bool pretty = ImGui::MenuItem("Pretty Printed");
+                if (compact || pretty)
+                {
+                    std::filesystem::path jsonPath = m_Context->GetProject()->GetFilePath();
+                    jsonPath.replace_extension(File::ProjectJSONExtension);
+                    m_ExportResult = m_Context->ExportProjectJSON(jsonPath, pretty);
+                    m_ShowExportResultDialog = true;
+                }
+                ImGui::EndMenu();
+            }
+
             ImGui::Separator();
 
             bool hasRecentProjects = m_Context && m_Context->HasRecentProjects();
@@ -250,10 +271,11 @@ namespace Tiles
         if (ImGui::BeginMenu("Project"))
         {
             bool hasProject = m_Context && m_Context->HasProject();
+            bool canResize = hasProject && !m_Context->GetProject()->GetLayerStack().IsUnbounded();
 
-            if (ImGui::MenuItem("Resize Project", nullptr, false, hasProject))
+            if (ImGui::MenuItem("Resize Project", nullptr, false, canResize))
             {
-                if (hasProject)
+                if (canResize)
                 {
                     // Initialize resize dialog with current dimensions
                     const auto& layerStack = m_Context->GetProject()->GetLayerStack();
@@ -273,7 +295,7 @@ namespace Tiles
                     const auto& layerStack = project->GetLayerStack();
 
                     ImGui::Text("Name: %s", project->GetProjectName().c_str());
-                    ImGui::Text("Dimensions: %dx%d", layerStack.GetWidth(), layerStack.GetHeight());
+                    ImGui::Text("Dimensions: %dx%d%s", layerStack.GetWidth(), layerStack.GetHeight(), layerStack.IsUnbounded() ? " (Infinite)" : "");
                     ImGui::Text("Layers: %zu", layerStack.GetLayerCount());
                     ImGui::Text("Atlases: %zu", project->GetTextureAtlasCount());
 
@@ -347,7 +369,8 @@ namespace Tiles
         m_Context->CreateProject(
             std::string(m_NewProjectName),
             static_cast<uint32_t>(m_NewProjectWidth),
-            static_cast<uint32_t>(m_NewProjectHeight)
+            static_cast<uint32_t>(m_NewProjectHeight),
+            m_NewProjectUnbounded
         );
     }
 
@@ -379,12 +402,16 @@ namespace Tiles
 
             ImGui::Spacing();
 
+            ImGui::Checkbox("Infinite Canvas##NewProject", &m_NewProjectUnbounded);
+
+            ImGui::BeginDisabled(m_NewProjectUnbounded);
             ImGui::Text("Dimensions:");
             ImGui::SetNextItemWidth(UI::Component::InputWidth);
             ImGui::InputInt("Width##NewProject", &m_NewProjectWidth);
             ImGui::SameLine();
             ImGui::SetNextItemWidth(UI::Component::InputWidth);
             ImGui::InputInt("Height##NewProject", &m_NewProjectHeight);
+            ImGui::EndDisabled();
 
             // Clamp values
             m_NewProjectWidth = std::max(1, std::min(1024, m_NewProjectWidth));
@@ -496,6 +523,33 @@ namespace Tiles
         ImGui::End();
     }
 
+    void PanelMenuBar::ShowExportResultDialog()
+    {
+        ImGui::SetNextWindowPos(ImGui::GetMainViewport()->GetCenter(), ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+
+        if (ImGui::Begin("Export JSON", &m_ShowExportResultDialog,
+            ImGuiWindowFlags_Modal | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize))
+        {
+            if (m_ExportResult.Success)
+            {
+                ImGui::TextColored(UI::Color::Green, "%s", m_ExportResult.Message.c_str());
+            }
+            else
+            {
+                ImGui::TextColored(UI::Color::TextError, "%s", m_ExportResult.Message.c_str());
+            }
+
+            ImGui::Spacing();
+            ImGui::Separator();
+
+            if (ImGui::Button("Close", ImVec2(80.0f, 0)))
+            {
+                m_ShowExportResultDialog = false;
+            }
+        }
+        ImGui::End();
+    }
+
     void PanelMenuBar::ShowFileDialog()
     {
         if (m_FileDialogMode == FileDialogMode::Open)
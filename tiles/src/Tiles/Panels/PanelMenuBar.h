@@ -30,6 +30,7 @@ namespace Tiles
         void ShowNewProjectDialog();
         void ShowResizeProjectDialog();
         void ShowAboutDialog();
+        void ShowExportResultDialog();
         void ShowFileDialog();
 
         // Helper methods
@@ -47,6 +48,7 @@ namespace Tiles
         bool m_ShowNewProjectDialog = false;
         bool m_ShowResizeProjectDialog = false;
         bool m_ShowAboutDialog = false;
+        bool m_ShowExportResultDialog = false;
         bool m_ShowOpenDialog = false;
         bool m_ShowSaveAsDialog = false;
 
@@ -54,6 +56,10 @@ namespace Tiles
         char m_NewProjectName[128] = "New Project";
         int m_NewProjectWidth = 32;
         int m_NewProjectHeight = 32;
+        bool m_NewProjectUnbounded = false;
+
+        // Result of the last JSON export, shown until closed
+        ProjectResult m_ExportResult;
 
         // Resize project dialog state
         int m_ResizeWidth = 32;
@@ -77,11 +77,27 @@ namespace Tiles
 
     void PanelTextureSelection::RenderBlockAtlasControls()
     {
+        // Packed tiles store the atlas index in a byte
+        bool canAddAtlas = m_Context->GetProject()->CanAddTextureAtlas();
+        if (!canAddAtlas)
+        {
+            ImGui::BeginDisabled();
+        }
+
         if (ImGui::Button("Add Atlas"))
         {
             AddNewAtlas();
         }
 
+        if (!canAddAtlas)
+        {
+            ImGui::EndDisabled();
+            if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+            {
+                ImGui::SetTooltip("Projects hold at most %zu atlases", PackedTile::MAX_ATLAS_COUNT);
+            }
+        }
+
         ImGui::SameLine();
 
         if (ImGui::Button("Remove Atlas"))
@@ -136,7 +152,7 @@ namespace Tiles
             if (ImGui::Button("Remove"))
             {
                 atlas->RemoveTexture();
-                m_Context->GetProject()->MarkAsModified();
+                m_Context->UpdateTextureAtlas(m_CurrentAtlasIndex);
             }
         }
     }
@@ -160,7 +176,7 @@ namespace Tiles
         if (width != atlas->GetWidth())
         {
             atlas->Resize(std::max(1, width), atlas->GetHeight());
-            m_Context->GetProject()->MarkAsModified();
+            m_Context->UpdateTextureAtlas(m_CurrentAtlasIndex);
         }
 
         int height = atlas->GetHeight();
@@ -168,7 +184,7 @@ namespace Tiles
         if (height != atlas->GetHeight())
         {
             atlas->Resize(atlas->GetWidth(), std::max(1, height));
-            m_Context->GetProject()->MarkAsModified();
+            m_Context->UpdateTextureAtlas(m_CurrentAtlasIndex);
         }
 
         ImGui::PopItemWidth();
@@ -240,6 +256,11 @@ namespace Tiles
             auto textureID = reinterpret_cast<void*>(static_cast<uintptr_t>(atlas->GetTexture()->GetID()));
 
             ImGui::Image(textureID, buttonSize, uvMin, uvMax, ImVec4(1, 1, 1, 1), ImVec4(0, 0, 0, 0));
+
+            if (ImGui::IsItemHovered())
+            {
+                ImGui::SetTooltip("Used by %zu tiles", GetAtlasUsage(atlasIndex, texCoords));
+            }
         }
         else
         {
@@ -338,7 +359,7 @@ namespace Tiles
             {
                 std::filesystem::path relativePath = std::filesystem::relative(newPath, std::filesystem::current_path());
                 atlas->SetTexture(relativePath.string());
-                m_Context->GetProject()->MarkAsModified();
+                m_Context->UpdateTextureAtlas(m_CurrentAtlasIndex);
             }
         }
     }
@@ -402,7 +423,7 @@ namespace Tiles
     void PanelTextureSelection::AddNewAtlas()
     {
         auto newAtlas = Lumina::TextureAtlas::Create(Texture::Atlas::DefaultWidth, Texture::Atlas::DefaultHeight);
-        m_Context->GetProject()->AddTextureAtlas(newAtlas);
+        m_Context->AddTextureAtlas(newAtlas);
         SetCurrentAtlasIndex(m_Context->GetProject()->GetTextureAtlasCount() - 1);
         m_Context->GetProject()->MarkAsModified();
     }
@@ -415,7 +436,7 @@ namespace Tiles
             return;
         }
 
-        m_Context->GetProject()->RemoveTextureAtlas(m_CurrentAtlasIndex);
+        m_Context->RemoveTextureAtlas(m_CurrentAtlasIndex);
 
         // Adjust current index if necessary
         if (m_CurrentAtlasIndex >= atlases.size() && !atlases.empty())
@@ -439,6 +460,23 @@ namespace Tiles
         }
     }
 
+    size_t PanelTextureSelection::GetAtlasUsage(size_t atlasIndex, const glm::vec4& textureCoords)
+    {
+        // Counting scans every chunk, so it only runs again once the hovered tile or the layers change
+        const LayerStack& layerStack = m_Context->GetProject()->GetLayerStack();
+        uint64_t generation = layerStack.GetGeneration();
+        if (m_UsageLayerStack != &layerStack || m_UsageGeneration != generation ||
+            m_UsageAtlasIndex != atlasIndex || m_UsageTextureCoords != textureCoords)
+        {
+            m_UsageLayerStack = &layerStack;
+            m_UsageGeneration = generation;
+            m_UsageAtlasIndex = atlasIndex;
+            m_UsageTextureCoords = textureCoords;
+            m_UsageCount = layerStack.CountAtlasUsage(atlasIndex, &textureCoords);
+        }
+        return m_UsageCount;
+    }
+
     bool PanelTextureSelection::HasValidCurrentAtlas() const
     {
         auto& atlases = m_Context->GetProject()->GetTextureAtlases();
@@ -39,10 +39,18 @@ namespace Tiles
         void AddNewAtlas();
         void RemoveCurrentAtlas();
         void SetCurrentAtlasIndex(size_t index);
+        size_t GetAtlasUsage(size_t atlasIndex, const glm::vec4& textureCoords);
         bool HasValidCurrentAtlas() const;
 
     private:
         Lumina::Ref<Lumina::Texture> m_CheckerboardTexture = nullptr;
         size_t m_CurrentAtlasIndex = 0;
+
+        // Last usage count shown in the hover tooltip, see GetAtlasUsage
+        const LayerStack* m_UsageLayerStack = nullptr;
+        uint64_t m_UsageGeneration = 0;
+        size_t m_UsageAtlasIndex = 0;
+        glm::vec4 m_UsageTextureCoords = glm::vec4(0.0f);
+        size_t m_UsageCount = 0;
     };
 }
\ No newline at end of file
@@ -71,6 +71,13 @@ namespace Tiles
         if (!m_Context || !m_Context->HasProject())
             return;
 
+        // Strokes end on release, even when the button comes up outside of the viewport
+        if (m_IsPainting && !Input::IsMouseButtonPressed(MouseCode::Left))
+        {
+            m_IsPainting = false;
+            m_Context->EndStroke();
+        }
+
         if (m_IsWindowFocused)
         {
             HandleInput();
@@ -172,6 +179,8 @@ namespace Tiles
         auto camera = m_Context->GetViewportCamera();
         glm::vec3 cameraPos = camera->GetPosition();
         const LayerStack& layerStack = m_Context->GetProject()->GetLayerStack();
+        if (layerStack.IsUnbounded())
+            return;
 
         const float gridWidth = layerStack.GetWidth();
         const float gridHeight = layerStack.GetHeight();
@@ -244,58 +253,57 @@ namespace Tiles
     }
 
     void PanelViewport::RenderLayer(const TileLayer& layer, size_t layerIndex, const glm::vec3& cameraPos)
+    {
+        layer.ForEachPaintedTile([&](int32_t x, int32_t y, const Tile& tile)
+            {
+                RenderTile(tile, x, y, layerIndex, cameraPos);
+            });
+    }
+
+    void PanelViewport::RenderTile(const Tile& tile, int32_t x, int32_t y, size_t layerIndex, const glm::vec3& cameraPos)
     {
         const auto& textureAtlases = m_Context->GetProject()->GetTextureAtlases();
 
-        for (size_t y = 0; y < layer.GetHeight(); ++y)
+        glm::vec2 tileWorldPos = {
+            (x + 1) * m_TileSize + cameraPos.x,
+            (y + 1) * m_TileSize + cameraPos.y
+        };
+
+        Renderer2D::SetQuadPosition({
+            tileWorldPos.x,
+            tileWorldPos.y,
+            Viewport::Depth::Tile + layerIndex * 0.01f
+            });
+        Renderer2D::SetQuadRotation(tile.GetRotation());
+        Renderer2D::SetQuadTintColor(tile.GetTint());
+
+        glm::vec2 tileSize = tile.GetSize();
+        Renderer2D::SetQuadSize({
+            m_TileSize * tileSize.x,
+            m_TileSize * tileSize.y
+            });
+
+        if (tile.IsTextured() && tile.GetAtlasIndex() < textureAtlases.size())
         {
-            for (size_t x = 0; x < layer.GetWidth(); ++x)
+            auto atlas = textureAtlases[tile.GetAtlasIndex()];
+            if (atlas && atlas->HasTexture())
+            {
+                Renderer2D::SetQuadTexture(atlas->GetTexture());
+                Renderer2D::SetQuadTextureCoords(tile.GetTextureCoords());
+            }
+            else
             {
-                const Tile& tile = layer.GetTile(x, y);
-                if (!tile.IsPainted()) continue;
-
-                glm::vec2 tileWorldPos = {
-                    (x + 1) * m_TileSize + cameraPos.x,
-                    (y + 1) * m_TileSize + cameraPos.y
-                };
-
-                Renderer2D::SetQuadPosition({
-                    tileWorldPos.x,
-                    tileWorldPos.y,
-                    Viewport::Depth::Tile + layerIndex * 0.01f
-                    });
-                Renderer2D::SetQuadRotation(tile.GetRotation());
-                Renderer2D::SetQuadTintColor(tile.GetTint());
-
-                glm::vec2 tileSize = tile.GetSize();
-                Renderer2D::SetQuadSize({
-                    m_TileSize * tileSize.x,
-                    m_TileSize * tileSize.y
-                    });
-
-                if (tile.IsTextured() && tile.GetAtlasIndex() < textureAtlases.size())
-                {
-                    auto atlas = textureAtlases[tile.GetAtlasIndex()];
-                    if (atlas && atlas->HasTexture())
-                    {
-                        Renderer2D::SetQuadTexture(atlas->GetTexture());
-                        Renderer2D::SetQuadTextureCoords(tile.GetTextureCoords());
-                    }
-                    else
-                    {
-                        Renderer2D::SetQuadTexture(nullptr);
-                        Renderer2D::SetQuadTextureCoords({ 0.0f, 0.0f, 1.0f, 1.0f });
-                    }
-                }
-                else
-                {
-                    Renderer2D::SetQuadTexture(nullptr);
-                    Renderer2D::SetQuadTextureCoords({ 0.0f, 0.0f, 1.0f, 1.0f });
-                }
-
-                Renderer2D::DrawQuad();
+                Renderer2D::SetQuadTexture(nullptr);
+                Renderer2D::SetQuadTextureCoords({ 0.0f, 0.0f, 1.0f, 1.0f });
             }
         }
+        else
+        {
+            Renderer2D::SetQuadTexture(nullptr);
+            Renderer2D::SetQuadTextureCoords({ 0.0f, 0.0f, 1.0f, 1.0f });
+        }
+
+        Renderer2D::DrawQuad();
     }
 
     void PanelViewport::RenderHoverTile()
@@ -406,17 +414,25 @@ namespace Tiles
 
     void PanelViewport::HandleInput()
     {
-        glm::ivec2 gridPos = GetGridPositionUnderMouse();
-        if (!IsValidGridPosition(gridPos)) 
+        if (!Input::IsMouseButtonPressed(MouseCode::Left))
             return;
 
-        if (Input::IsMouseButtonPressed(MouseCode::Left))
+        // Everything painted until the button is released is undone as one stroke
+        bool isNewPress = !m_IsPainting;
+        if (isNewPress)
         {
-            ExecutePaintAction(gridPos);
+            m_IsPainting = true;
+            m_Context->BeginStroke();
         }
+
+        glm::ivec2 gridPos = GetGridPositionUnderMouse();
+        if (!IsValidGridPosition(gridPos)) 
+            return;
+
+        ExecutePaintAction(gridPos, isNewPress);
     }
 
-    void PanelViewport::ExecutePaintAction(const glm::ivec2& gridPos)
+    void PanelViewport::ExecutePaintAction(const glm::ivec2& gridPos, bool isNewPress)
     {
         PaintingMode mode = m_Context->GetPaintingMode();
 
@@ -429,7 +445,9 @@ namespace Tiles
             m_Context->EraseTile(gridPos.x - 1, gridPos.y - 1);
             break;
         case PaintingMode::Fill:
-            m_Context->FillLayer(gridPos.x - 1, gridPos.y - 1);
+            // One fill per click, holding the button would only add empty fills to the history
+            if (isNewPress)
+                m_Context->FillLayer(gridPos.x - 1, gridPos.y - 1);
             break;
         default:
             break;
@@ -448,6 +466,9 @@ namespace Tiles
     bool PanelViewport::IsValidGridPosition(const glm::ivec2& gridPos) const
     {
         const LayerStack& layerStack = m_Context->GetProject()->GetLayerStack();
+        if (layerStack.IsUnbounded())
+            return true;
+
         return gridPos.x >= 1 && gridPos.x <= static_cast<int>(layerStack.GetWidth()) &&
             gridPos.y >= 1 && gridPos.y <= static_cast<int>(layerStack.GetHeight());
     }
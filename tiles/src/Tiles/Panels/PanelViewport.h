@@ -28,13 +28,14 @@ namespace Tiles
         void RenderLayerBoundaries();
         void RenderLayers();
         void RenderLayer(const TileLayer& layer, size_t layerIndex, const glm::vec3& cameraPos);
+        void RenderTile(const Tile& tile, int32_t x, int32_t y, size_t layerIndex, const glm::vec3& cameraPos);
         void RenderHoverTile();
         void RenderBrushPreview(const Tile& brush, const glm::vec3& cameraPos);
         void RenderEraserPreview();
         void RenderFillPreview();
         void RenderBasicHover();
 
-        void ExecutePaintAction(const glm::ivec2& gridPos);
+        void ExecutePaintAction(const glm::ivec2& gridPos, bool isNewPress);
 
         void HandleInput();
         void HandleMouseDragging(); 
@@ -47,6 +48,7 @@ namespace Tiles
         float m_TileSize;
         float m_MouseDelta = 0.0f;
         bool m_IsDragging = false;
+        bool m_IsPainting = false;                  // Left button held since a press inside the viewport
         bool m_IsWindowFocused = false; 
 
         ImVec2 m_CurrentMousePosition = { 0.0f, 0.0f };
@@ -126,7 +126,7 @@ namespace Tiles
             ImGuiFileDialog::Instance()->OpenDialog(
                 "ChooseProjectFileDlg",
                 "Choose Project File",
-                FILTER_EXTENSION,
+                FILTER_EXTENSIONS,
                 config
             );
 
@@ -277,6 +277,6 @@ namespace Tiles
 
         m_FilePathValid = std::filesystem::exists(fullPath) &&
             std::filesystem::is_regular_file(fullPath) &&
-            fullPath.extension().string() == FILTER_EXTENSION;
+            (fullPath.extension().string() == FILTER_EXTENSION || fullPath.extension().string() == File::ProjectJSONExtension);
     }
 }
\ No newline at end of file
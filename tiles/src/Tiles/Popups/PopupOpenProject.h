@@ -37,5 +37,6 @@ namespace Tiles
 
         static constexpr float MESSAGE_DISPLAY_TIME = 3.0f;
         static constexpr const char* FILTER_EXTENSION = ".tiles";
+        static constexpr const char* FILTER_EXTENSIONS = ".tiles,.json";    // JSON exports open as projects too
     };
 }
\ No newline at end of file
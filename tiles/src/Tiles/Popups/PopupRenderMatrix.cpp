@@ -505,8 +505,13 @@ namespace Tiles
 
         const auto& layerStack = m_Context->GetProject()->GetLayerStack();
 
-        uint32_t width = layerStack.GetWidth() * Viewport::Render::DefaultTileSize;
-        uint32_t height = layerStack.GetHeight() * Viewport::Render::DefaultTileSize;
+        // Unbounded stacks export the area covered by painted tiles
+        TileBounds bounds = layerStack.GetBounds();
+        if (bounds.IsEmpty())
+            return;
+
+        uint32_t width = bounds.GetWidth() * Viewport::Render::DefaultTileSize;
+        uint32_t height = bounds.GetHeight() * Viewport::Render::DefaultTileSize;
 
         auto renderTarget = Renderer2D::CreateRenderTarget(width, height);
         auto camera = CreateRef<OrthographicCamera>();
@@ -534,16 +539,11 @@ namespace Tiles
 
             const auto& layer = layerStack.GetLayer(layerIdx);
 
-            for (size_t y = 0; y < layer.GetHeight(); ++y)
-            {
-                for (size_t x = 0; x < layer.GetWidth(); ++x)
+            layer.ForEachPaintedTile([&](int32_t x, int32_t y, const Tile& tile)
                 {
-                    const Tile& tile = layer.GetTile(x, y);
-                    if (!tile.IsPainted()) continue;
-
                     glm::vec2 tileWorldPos = {
-                        (x + 1) * tileSize + cameraPos.x,
-                        (y + 1) * tileSize + cameraPos.y
+                        (x - bounds.MinX + 1) * tileSize + cameraPos.x,
+                        (y - bounds.MinY + 1) * tileSize + cameraPos.y
                     };
 
                     Renderer2D::SetQuadPosition({
@@ -575,8 +575,7 @@ namespace Tiles
                     }
 
                     Renderer2D::DrawQuad();
-                }
-            }
+                });
         }
 
         Renderer2D::End();